@@ -0,0 +1,54 @@
+# Copyright 2016-present, Facebook, Inc.
+# All rights reserved.
+#
+# This source code is licensed under the license found in the
+# LICENSE file in the root directory of this source tree.
+
+# Latency of a Plus-augmented VGG net on CPU, with the branches of its
+# ConcatTables run one after another and in parallel, for several OpenMP team
+# sizes:
+#   python examples/benchmarks/concat_table.py [spatial size] [points]
+# The spatial size must be 2^k - 1 for the strided branches.
+
+import sys
+import time
+import torch
+import sparseconvnet as scn
+import sparseconvnet_SCN
+
+size = int(sys.argv[1]) if len(sys.argv) > 1 else 63
+n = int(sys.argv[2]) if len(sys.argv) > 2 else 50000
+
+model = scn.Sequential().add(
+    scn.SubmanifoldConvolution(3, 1, 32, 3, False)
+).add(
+    scn.SparseVggNet(3, 32, [['C', 32, 32, 32, 32], ['C', 32, 32, 32, 32]])
+).eval()
+
+locations = torch.LongTensor(n, 3).random_(size)
+features = torch.FloatTensor(n, 1).normal_()
+
+
+def latency(parallel, reps=5):
+    scn.set_parallel_branches(model, parallel)
+    best = float('inf')
+    for rep in range(reps):
+        input = scn.InputBatch(3, size)
+        input.add_sample()
+        input.set_locations(locations, features, 0)
+        start = time.time()
+        with torch.no_grad():
+            model(input)
+        best = min(best, time.time() - start)
+    return best * 1000
+
+
+max_threads = sparseconvnet_SCN.get_omp_threads()
+threads = 1
+while threads <= max_threads:
+    sparseconvnet_SCN.set_omp_threads(threads)
+    serial, parallel = latency(False), latency(True)
+    print('%2d OpenMP threads: serial %.1f ms, parallel %.1f ms' %
+          (threads, serial, parallel))
+    threads *= 2
+sparseconvnet_SCN.set_omp_threads(max_threads)
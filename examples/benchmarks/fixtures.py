@@ -0,0 +1,51 @@
+# Copyright 2016-present, Facebook, Inc.
+# All rights reserved.
+#
+# This source code is licensed under the license found in the
+# LICENSE file in the root directory of this source tree.
+
+# Active site distributions shared by the benchmarks. Each returns a LongTensor
+# of locations, one row per site.
+
+import torch
+
+
+def sheet(size, samples=None):
+    """A sheet three voxels thick, as (x, y, z) rows; given a number of
+    samples, one shifted sheet per sample, as (x, y, z, sample) rows."""
+    r = torch.arange(size).long()
+    x = r.view(-1, 1).expand(size, size).contiguous().view(-1)
+    y = r.view(1, -1).expand(size, size).contiguous().view(-1)
+    locations = []
+    for b in range(samples or 1):
+        z = (x * 7 + y * 3 + b * 11) % size
+        for dz in range(3):
+            keep = z + dz < size
+            rows = [x[keep], y[keep], z[keep] + dz]
+            if samples is not None:
+                rows.append(torch.LongTensor(int(keep.sum())).fill_(b))
+            locations.append(torch.stack(rows, 1))
+    return torch.cat(locations, 0)
+
+
+def block(size):
+    """Every site of a size^3 grid"""
+    r = torch.arange(size).long()
+    return torch.stack([r.view(-1, 1, 1).expand(size, size, size),
+                        r.view(1, -1, 1).expand(size, size, size),
+                        r.view(1, 1, -1).expand(size, size, size)],
+                       3).contiguous().view(-1, 3)
+
+
+def shell(size, r0, r1):
+    """The sites at distance r0 <= r < r1 from the centre of a size^3 grid"""
+    r = torch.arange(size).long() - size // 2
+    yz = r.view(-1, 1) ** 2 + r.view(1, -1) ** 2
+    slices = []
+    for x in range(size):
+        r2 = yz + (x - size // 2) ** 2
+        yz_ = ((r2 >= r0 * r0) & (r2 < r1 * r1)).nonzero()
+        if len(yz_):
+            slices.append(torch.cat(
+                [torch.LongTensor(len(yz_), 1).fill_(x), yz_], 1))
+    return torch.cat(slices, 0)
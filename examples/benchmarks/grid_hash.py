@@ -0,0 +1,40 @@
+# Copyright 2016-present, Facebook, Inc.
+# All rights reserved.
+#
+# This source code is licensed under the license found in the
+# LICENSE file in the root directory of this source tree.
+
+# Time to hash the active sites of some voxel distributions into the input
+# grid, and to look up their 3x3x3 neighbourhoods for a submanifold
+# convolution:
+#   python examples/benchmarks/grid_hash.py
+
+import time
+import torch
+import sparseconvnet as scn
+from fixtures import sheet, block, shell
+
+
+def latency(size, locations, reps=5):
+    features = torch.FloatTensor(locations.size(0), 1).fill_(1)
+    model = scn.SubmanifoldConvolution(3, 1, 1, 3, False)
+    insert = lookup = float('inf')
+    for rep in range(reps):
+        input = scn.InputBatch(3, size)
+        input.add_sample()
+        start = time.time()
+        input.set_locations(locations, features, True)
+        middle = time.time()
+        with torch.no_grad():
+            model(input)
+        insert = min(insert, middle - start)
+        lookup = min(lookup, time.time() - middle)
+    return insert * 1000, lookup * 1000
+
+
+for name, size, locations in [('sheet in 128^3', 128, sheet(128)),
+                              ('solid 48^3 block', 48, block(48)),
+                              ('sphere shell in 256^3', 256,
+                               shell(256, 120, 122))]:
+    print('%s, %d sites: insert %.1f ms, 3x3x3 rulebook %.1f ms' %
+          ((name, locations.size(0)) + latency(size, locations)))
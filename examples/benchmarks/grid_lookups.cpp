@@ -0,0 +1,137 @@
+// Copyright 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+// Probe lengths and lookup rates of the key layouts of SparseGridMap, on the
+// voxel distributions of grid_hash.py: Point<3> keys in a dense_hash_map with
+// the FNV hash (IntArrayHash) and with the murmur3 mixing hash
+// (IntArrayMixHash), and packed keys in a PackedHashTable. Each active site
+// looks up its 3x3x3 neighbourhood; a probe is one bucket examined. Build and
+// run in examples/benchmarks, with INC the -I flags for the directories of
+// torch.utils.cpp_extension.include_paths():
+//   g++ -std=c++11 -O2 -I../../sparseconvnet/SCN $INC grid_lookups.cpp
+//   ./a.out
+
+#include <torch/torch.h>
+
+#include "Metadata/32bits.h"
+#include "Metadata/SparseGridMap.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using Points = std::vector<Point<3>>;
+
+// dense_hash_map tests each bucket it examines against the empty key before
+// comparing keys, so the probes are the comparisons with the empty key.
+long nProbes = 0;
+struct CountingEqual {
+  bool operator()(const Point<3> &a, const Point<3> &b) const {
+    nProbes += a[0] == -1 or b[0] == -1;
+    return a == b;
+  }
+};
+
+void report(const char *name, long n, long found, long probes, long longest,
+            double seconds) {
+  printf("  %-13s %4.1f%% found, %5.2f probes, longest %3ld, "
+         "%6.1f M lookups/s\n",
+         name, 100.0 * found / n, (double)probes / n, longest,
+         n / seconds / 1e6);
+}
+
+// The neighbours with negative coordinates are left out, as the packed
+// layout rejects them without a lookup
+template <typename F> void forEachNeighbour(const Points &points, F f) {
+  for (auto &p : points)
+    for (Int i = -1; i <= 1; i++)
+      for (Int j = -1; j <= 1; j++)
+        for (Int k = -1; k <= 1; k++) {
+          Point<3> q{{p[0] + i, p[1] + j, p[2] + k}};
+          if (q[0] >= 0 and q[1] >= 0 and q[2] >= 0)
+            f(q);
+        }
+}
+
+template <typename Hash> void arrayMap(const char *name, const Points &points) {
+  Point<3> empty{{-1, -1, -1}};
+  google::dense_hash_map<Point<3>, Int, Hash, CountingEqual> counted;
+  typename SparseGridMap<3, Hash>::ArrayMap timed;
+  counted.set_empty_key(empty);
+  timed.set_empty_key(empty);
+  for (Int i = 0; i < (Int)points.size(); i++)
+    counted[points[i]] = timed[points[i]] = i;
+  long n = 0, probes = 0, longest = 0;
+  forEachNeighbour(points, [&](const Point<3> &p) {
+    nProbes = 0;
+    counted.find(p);
+    n++;
+    probes += nProbes;
+    longest = std::max(longest, nProbes);
+  });
+  long found = 0;
+  auto start = std::chrono::steady_clock::now();
+  forEachNeighbour(points,
+                   [&](const Point<3> &p) { found += timed.count(p); });
+  std::chrono::duration<double> t = std::chrono::steady_clock::now() - start;
+  report(name, n, found, probes, longest, t.count());
+}
+
+void packedMap(const Points &points) {
+  PackedHashTable table;
+  for (Int i = 0; i < (Int)points.size(); i++)
+    table[SparseGridMap<3>::pack(points[i])] = i;
+  long n = 0, probes = 0, longest = 0;
+  forEachNeighbour(points, [&](const Point<3> &p) {
+    uint64_t k = SparseGridMap<3>::pack(p);
+    long m = 1;
+    for (std::size_t i = table.bucket(k);
+         table.keys[i] != k and table.keys[i] != packedEmptyKey;
+         i = (i + 1) & table.mask)
+      m++;
+    n++;
+    probes += m;
+    longest = std::max(longest, m);
+  });
+  long found = 0;
+  auto start = std::chrono::steady_clock::now();
+  forEachNeighbour(points, [&](const Point<3> &p) {
+    found += table.find(SparseGridMap<3>::pack(p)) < table.capacity();
+  });
+  std::chrono::duration<double> t = std::chrono::steady_clock::now() - start;
+  report("packed", n, found, probes, longest, t.count());
+}
+
+void run(const char *name, const Points &points) {
+  printf("%s, %ld sites\n", name, (long)points.size());
+  arrayMap<IntArrayHash<3>>("FNV", points);
+  arrayMap<IntArrayMixHash<3>>("murmur3 mix", points);
+  packedMap(points);
+}
+
+int main() {
+  Points sheet, block, shell;
+  for (Int x = 0; x < 128; x++)
+    for (Int y = 0; y < 128; y++) {
+      Int z = (x * 7 + y * 3) % 128;
+      for (Int dz = 0; dz < 3 and z + dz < 128; dz++)
+        sheet.push_back({{x, y, z + dz}});
+    }
+  for (Int x = 0; x < 48; x++)
+    for (Int y = 0; y < 48; y++)
+      for (Int z = 0; z < 48; z++)
+        block.push_back({{x, y, z}});
+  for (Int x = 0; x < 256; x++)
+    for (Int y = 0; y < 256; y++)
+      for (Int z = 0; z < 256; z++) {
+        Int r2 = (x - 128) * (x - 128) + (y - 128) * (y - 128) +
+                 (z - 128) * (z - 128);
+        if (r2 >= 120 * 120 and r2 < 122 * 122)
+          shell.push_back({{x, y, z}});
+      }
+  run("sheet in 128^3", sheet);
+  run("solid 48^3 block", block);
+  run("sphere shell in 256^3", shell);
+}
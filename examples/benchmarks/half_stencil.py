@@ -0,0 +1,44 @@
+# Copyright 2016-present, Facebook, Inc.
+# All rights reserved.
+#
+# This source code is licensed under the license found in the
+# LICENSE file in the root directory of this source tree.
+
+# Latency of a single channel submanifold convolution on a fresh batch of
+# surfaces in a 3D grid, which is mostly the time to build its rulebook, for
+# odd and even filter sizes; odd ones are built from half the stencil:
+#   python examples/benchmarks/half_stencil.py [spatial size] [samples]
+
+import sys
+import time
+import torch
+import sparseconvnet as scn
+from fixtures import sheet
+
+size = int(sys.argv[1]) if len(sys.argv) > 1 else 160
+samples = int(sys.argv[2]) if len(sys.argv) > 2 else 2
+
+locations = sheet(size, samples)
+features = torch.FloatTensor(locations.size(0), 1).fill_(1)
+spatial_size = torch.LongTensor([size] * 3)
+
+
+def build(filter_size, reps=5):
+    model = scn.SubmanifoldConvolution(3, 1, 1, filter_size, False)
+    best = float('inf')
+    for rep in range(reps):
+        input = scn.InputBatch(3, spatial_size)
+        for b in range(samples):
+            input.add_sample()
+        input.set_locations(locations, features, True)
+        start = time.time()
+        with torch.no_grad():
+            model(input)
+        best = min(best, time.time() - start)
+    return best * 1000
+
+
+print('%d active sites' % locations.size(0))
+for filter_size in [2, 3, 4, 5]:
+    print('%dx%dx%d: %.1f ms' %
+          ((filter_size,) * 3 + (build(filter_size),)))
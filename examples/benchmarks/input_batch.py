@@ -0,0 +1,37 @@
+# Copyright 2016-present, Facebook, Inc.
+# All rights reserved.
+#
+# This source code is licensed under the license found in the
+# LICENSE file in the root directory of this source tree.
+
+# Time to fill an InputBatch from uniformly random points with set_locations,
+# as a data loader worker would, for one sample and for a batch of eight:
+#   python examples/benchmarks/input_batch.py [spatial size]
+
+import sys
+import time
+import torch
+import sparseconvnet as scn
+
+size = int(sys.argv[1]) if len(sys.argv) > 1 else 256
+
+
+def latency(n, samples, reps=5):
+    locations = torch.cat([torch.LongTensor(n, 3).random_(size),
+                           torch.arange(n).long().view(-1, 1) % samples], 1)
+    features = torch.FloatTensor(n, 4).zero_()
+    best = float('inf')
+    for rep in range(reps):
+        input = scn.InputBatch(3, size)
+        for b in range(samples):
+            input.add_sample()
+        start = time.time()
+        input.set_locations(locations, features, True)
+        best = min(best, time.time() - start)
+    return best * 1000
+
+
+for n in [100000, 1000000]:
+    for samples in [1, 8]:
+        print('%7d points, %d samples: %.1f ms' %
+              (n, samples, latency(n, samples)))
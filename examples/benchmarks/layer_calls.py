@@ -0,0 +1,53 @@
+# Copyright 2016-present, Facebook, Inc.
+# All rights reserved.
+#
+# This source code is licensed under the license found in the
+# LICENSE file in the root directory of this source tree.
+
+# Latency of the forward and backward passes of a submanifold and a strided
+# convolution once their rulebooks are built, which is the cost of each layer
+# call in training, and the bytes that each call allocates for rulebook copies
+# and kernel scratch space; the kernels borrow the cached rulebooks rather than
+# copy them:
+#   python examples/benchmarks/layer_calls.py [spatial size] [samples] [planes]
+
+import sys
+import time
+import torch
+import sparseconvnet as scn
+import sparseconvnet_SCN
+from fixtures import sheet
+
+size = int(sys.argv[1]) if len(sys.argv) > 1 else 96
+samples = int(sys.argv[2]) if len(sys.argv) > 2 else 2
+planes = int(sys.argv[3]) if len(sys.argv) > 3 else 16
+
+locations = sheet(size, samples)
+features = torch.FloatTensor(locations.size(0), planes).normal_()
+
+
+def latency(layer, reps=5):
+    input = scn.InputBatch(3, size)
+    for b in range(samples):
+        input.add_sample()
+    input.set_locations(locations, features, True)
+    input.features.requires_grad = True
+    best = float('inf')
+    for rep in range(reps + 1):
+        # The first call builds the rulebook
+        if rep == 1:
+            allocated = sparseconvnet_SCN.scratch_bytes()
+        start = time.time()
+        output = layer(input)
+        output.features.sum().backward()
+        if rep:
+            best = min(best, time.time() - start)
+    allocated = sparseconvnet_SCN.scratch_bytes() - allocated
+    return best * 1000, allocated / reps / 1024
+
+
+print('%d active sites, %d planes' % (locations.size(0), planes))
+print('submanifold 3x3x3 forward+backward: %.1f ms, %.1f KiB' % latency(
+    scn.SubmanifoldConvolution(3, planes, planes, 3, False)))
+print('convolution 2/2 forward+backward: %.1f ms, %.1f KiB' % latency(
+    scn.Convolution(3, planes, planes, 2, 2, False)))
@@ -0,0 +1,49 @@
+# Copyright 2016-present, Facebook, Inc.
+# All rights reserved.
+#
+# This source code is licensed under the license found in the
+# LICENSE file in the root directory of this source tree.
+
+# Forward latency of a submanifold convolution on CPU, with its rulebook or
+# neighbour table already built, computed offset by offset and one output row
+# at a time (output_stationary=True):
+#   python examples/benchmarks/output_stationary.py [spatial size] [samples]
+
+import sys
+import time
+import torch
+import sparseconvnet as scn
+from fixtures import sheet
+
+size = int(sys.argv[1]) if len(sys.argv) > 1 else 96
+samples = int(sys.argv[2]) if len(sys.argv) > 2 else 2
+
+locations = sheet(size, samples)
+
+
+def latency(planes, filter_size, output_stationary, reps=5):
+    input = scn.InputBatch(3, size)
+    for b in range(samples):
+        input.add_sample()
+    features = torch.FloatTensor(locations.size(0), planes).normal_()
+    input.set_locations(locations, features, True)
+    layer = scn.SubmanifoldConvolution(3, planes, planes, filter_size, False,
+                                       output_stationary)
+    best = float('inf')
+    with torch.no_grad():
+        for rep in range(reps + 1):
+            start = time.time()
+            layer(input)
+            # The first call builds the rulebook or neighbour table
+            if rep:
+                best = min(best, time.time() - start)
+    return best * 1000
+
+
+print('%d active sites' % locations.size(0))
+for planes in [16, 32, 64]:
+    for filter_size in [3, 5]:
+        print('%2d planes, filter size %d: offset-major %.1f ms, '
+              'output-stationary %.1f ms' %
+              (planes, filter_size, latency(planes, filter_size, False),
+               latency(planes, filter_size, True)))
@@ -0,0 +1,49 @@
+# Copyright 2016-present, Facebook, Inc.
+# All rights reserved.
+#
+# This source code is licensed under the license found in the
+# LICENSE file in the root directory of this source tree.
+
+# Time to build the rulebooks of a submanifold and a strided convolution on a
+# single large scene, the batch size 1 inference case, for several OpenMP team
+# sizes; the active sites of the sample are split between the threads:
+#   python examples/benchmarks/rulebook_threads.py [spatial size]
+
+import sys
+import time
+import torch
+import sparseconvnet as scn
+import sparseconvnet_SCN
+from fixtures import sheet
+
+size = int(sys.argv[1]) if len(sys.argv) > 1 else 160
+
+locations = sheet(size)
+features = torch.FloatTensor(locations.size(0), 1).fill_(1)
+
+
+def build(layer, reps=5):
+    best = float('inf')
+    for rep in range(reps):
+        input = scn.InputBatch(3, size)
+        input.add_sample()
+        input.set_locations(locations, features, True)
+        start = time.time()
+        with torch.no_grad():
+            layer(input)
+        best = min(best, time.time() - start)
+    return best * 1000
+
+
+submanifold = scn.SubmanifoldConvolution(3, 1, 1, 3, False)
+strided = scn.Convolution(3, 1, 1, 2, 2, False)
+print('%d active sites' % locations.size(0))
+max_threads = sparseconvnet_SCN.get_omp_threads()
+threads = 1
+while threads <= max_threads:
+    sparseconvnet_SCN.set_omp_threads(threads)
+    print('%2d OpenMP threads: submanifold 3x3x3 %.1f ms, '
+          'convolution 2/2 %.1f ms' % (threads, build(submanifold),
+                                        build(strided)))
+    threads *= 2
+sparseconvnet_SCN.set_omp_threads(max_threads)
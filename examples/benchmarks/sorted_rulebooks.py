@@ -0,0 +1,47 @@
+# Copyright 2016-present, Facebook, Inc.
+# All rights reserved.
+#
+# This source code is licensed under the license found in the
+# LICENSE file in the root directory of this source tree.
+
+# Time to build the rulebooks of a submanifold and a strided convolution on a
+# batch of surfaces in a 3D grid, with hash lookups and with the sort-based
+# builder (Metadata.setSortedRuleBooks):
+#   python examples/benchmarks/sorted_rulebooks.py [spatial size] [samples]
+
+import sys
+import time
+import torch
+import sparseconvnet as scn
+from fixtures import sheet
+
+size = int(sys.argv[1]) if len(sys.argv) > 1 else 128
+samples = int(sys.argv[2]) if len(sys.argv) > 2 else 2
+
+locations = sheet(size, samples)
+features = torch.FloatTensor(locations.size(0), 1).fill_(1)
+spatial_size = torch.LongTensor([size] * 3)
+
+
+def build(layer, sorted, reps=5):
+    best = float('inf')
+    for rep in range(reps):
+        input = scn.InputBatch(3, spatial_size)
+        input.metadata.setSortedRuleBooks(sorted)
+        for b in range(samples):
+            input.add_sample()
+        input.set_locations(locations, features, True)
+        start = time.time()
+        with torch.no_grad():
+            layer(input)
+        best = min(best, time.time() - start)
+    return best * 1000
+
+
+print('%d active sites' % locations.size(0))
+for name, layer in [
+        ('submanifold 3x3x3', scn.SubmanifoldConvolution(3, 1, 1, 3, False)),
+        ('submanifold 5x5x5', scn.SubmanifoldConvolution(3, 1, 1, 5, False)),
+        ('convolution 2/2', scn.Convolution(3, 1, 1, 2, 2, False))]:
+    print('%s: hash %.1f ms, sorted %.1f ms' %
+          (name, build(layer, False), build(layer, True)))
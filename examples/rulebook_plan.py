@@ -0,0 +1,50 @@
+# Copyright 2016-present, Facebook, Inc.
+# All rights reserved.
+#
+# This source code is licensed under the license found in the
+# LICENSE file in the root directory of this source tree.
+
+# Smoke test for sparseconvnet.rulebook_plan: precompute the rulebooks of a
+# network with randomized stride layers, in training and in test mode, and
+# run it forward.
+
+import torch
+import sparseconvnet as scn
+from sparseconvnet.utils import RANDOMIZED_STRIDE_RULEBOOK
+
+model = scn.Sequential().add(
+    scn.SubmanifoldConvolution(2, 1, 8, 3, False)
+).add(
+    scn.RandomizedStrideMaxPooling(2, 3, 2)
+).add(
+    scn.RandomizedStrideConvolution(2, 8, 8, 3, 2, False)
+).add(
+    scn.SparseToDense(2, 8)
+)
+
+# output will be 5x5
+inputSpatialSize = model.input_spatial_size(torch.LongTensor([5, 5]))
+
+
+def batch():
+    input = scn.InputBatch(2, inputSpatialSize)
+    for sample in range(2):
+        input.add_sample()
+        locations = torch.randperm(inputSpatialSize.prod().item())[:100]
+        locations = torch.stack([locations / inputSpatialSize[1],
+                                 locations % inputSpatialSize[1]], 1)
+        input.set_locations(locations, torch.FloatTensor(100, 1).fill_(1))
+    return input
+
+
+for training in [True, False]:
+    model.train(training)
+    plan = scn.rulebook_plan(model, inputSpatialSize)
+    kinds = [kind for kind, i, o, f, s in plan]
+    assert (RANDOMIZED_STRIDE_RULEBOOK in kinds) == training, kinds
+    input = batch()
+    input.precompute_metadata(plan)
+    output = model.forward(input)
+    assert output.shape == (2, 8, 5, 5), output.shape
+    print('training' if training else 'test', 'mode:', len(plan),
+          'rulebooks planned, output', tuple(output.shape))
@@ -13,7 +13,7 @@ void cpu_ActivePooling_updateOutput(
     /*float*/ at::Tensor output_features, bool average) {
 
   Int nPlanes = input_features.size(1);
-  auto _rules = m.getActivePoolingRuleBook(inputSize);
+  auto &_rules = m.getActivePoolingRuleBook(inputSize);
   Int batchSize = _rules[1][0];
   Int maxActive = _rules[1][1];
   output_features.resize_({batchSize, nPlanes});
@@ -32,7 +32,7 @@ void cpu_ActivePooling_updateGradInput(
     /*float*/ at::Tensor d_output_features, bool average) {
 
   Int nPlanes = input_features.size(1);
-  auto _rules = m.getActivePoolingRuleBook(inputSize);
+  auto &_rules = m.getActivePoolingRuleBook(inputSize);
   Int batchSize = _rules[1][0];
   Int maxActive = _rules[1][1];
   d_input_features.resize_as_(input_features);
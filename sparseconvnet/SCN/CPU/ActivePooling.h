@@ -12,7 +12,7 @@
 template <typename T>
 void ActivePooling_ForwardPass(T *input_features, T *output_features,
                                Int batchSize, Int maxActive, Int nPlanes,
-                               RuleBook &rules, bool average) {
+                               TableRuleBook &rules, bool average) {
   for (Int outSite = 0; outSite < batchSize; outSite++) {
     T *out = &output_features[outSite * nPlanes];
     Int *r = &rules[0][outSite * (maxActive + 1)];
@@ -28,7 +28,7 @@ void ActivePooling_ForwardPass(T *input_features, T *output_features,
 template <typename T>
 void ActivePooling_BackwardPass(T *d_input_features, T *d_output_features,
                                 Int batchSize, Int maxActive, Int nPlanes,
-                                RuleBook &rules, bool average) {
+                                TableRuleBook &rules, bool average) {
   for (Int outSite = 0; outSite < batchSize; outSite++) {
     T *out = &d_output_features[outSite * nPlanes];
     Int *r = &rules[0][outSite * (maxActive + 1)];
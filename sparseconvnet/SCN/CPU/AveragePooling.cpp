@@ -15,7 +15,7 @@ void cpu_AveragePooling_updateOutput(
     /*float*/ at::Tensor output_features, long nFeaturesToDrop) {
 
   Int nPlanes = input_features.size(1) - nFeaturesToDrop;
-  auto _rules =
+  auto &_rules =
       m.getRuleBook(inputSize, outputSize, poolSize, poolStride, true);
   Int nActive = m.getNActive(outputSize);
   output_features.resize_({nActive, input_features.size(1) - nFeaturesToDrop});
@@ -24,10 +24,10 @@ void cpu_AveragePooling_updateOutput(
   auto iF = input_features.data<T>() + nFeaturesToDrop;
   auto oF = output_features.data<T>();
 
-  for (auto &r : _rules) {
-    Int nHot = r.size() / 2;
+  for (Int k = 0; k < _rules.size(); k++) {
+    Int nHot = _rules.nRules(k);
     AveragePooling_ForwardPass<T>(iF, oF, nPlanes, input_features.stride(0),
-                                  output_features.stride(0), &r[0], nHot,
+                                  output_features.stride(0), _rules[k], nHot,
                                   _rules.size());
   }
 }
@@ -41,7 +41,7 @@ void cpu_AveragePooling_updateGradInput(
     /*float*/ at::Tensor d_output_features, long nFeaturesToDrop) {
 
   Int nPlanes = input_features.size(1) - nFeaturesToDrop;
-  auto _rules =
+  auto &_rules =
       m.getRuleBook(inputSize, outputSize, poolSize, poolStride, true);
   d_input_features.resize_as_(input_features);
   d_input_features.zero_();
@@ -49,10 +49,10 @@ void cpu_AveragePooling_updateGradInput(
   auto diF = d_input_features.data<T>() + nFeaturesToDrop;
   auto doF = d_output_features.data<T>();
 
-  for (auto &r : _rules) {
-    Int nHot = r.size() / 2;
+  for (Int k = 0; k < _rules.size(); k++) {
+    Int nHot = _rules.nRules(k);
     AveragePooling_BackwardPass<T>(diF, doF, nPlanes, input_features.stride(0),
-                                   d_output_features.stride(0), &r[0], nHot,
+                                   d_output_features.stride(0), _rules[k], nHot,
                                    _rules.size());
   }
 }
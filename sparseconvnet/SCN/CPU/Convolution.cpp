@@ -4,29 +4,7 @@
 // This source code is licensed under the license found in the
 // LICENSE file in the root directory of this source tree.
 
-#include <cstring>
-template <typename T>
-void rule_index_select(at::Tensor target, at::Tensor src, Int nRules,
-                       Int *rules) {
-  auto t_ptr = target.data<T>();
-  auto s_ptr = src.data<T>();
-  auto n = target.size(1);
-  for (int i = 0; i < nRules; ++i)
-    std::memcpy(t_ptr + i * n, s_ptr + rules[2 * i] * n, sizeof(T) * n);
-}
-template <typename T>
-void rule_index_add_(at::Tensor target, at::Tensor src, Int nRules,
-                     Int *rules) {
-  auto t_ptr = target.data<T>();
-  auto s_ptr = src.data<T>();
-  auto n = target.size(1);
-  for (int i = 0; i < nRules; ++i) {
-    auto t = t_ptr + rules[2 * i] * n;
-    auto s = s_ptr + i * n;
-    for (int j = 0; j < n; ++j)
-      t[j] += s[j];
-  }
-}
+#include "Convolution.h"
 
 template <typename T, Int Dimension>
 double cpu_Convolution_updateOutput(
@@ -36,7 +14,7 @@ double cpu_Convolution_updateOutput(
     /*float*/ at::Tensor input_features,
     /*float*/ at::Tensor output_features, /*float*/ at::Tensor weight,
     /*float*/ at::Tensor bias) {
-  auto _rules =
+  auto &_rules =
       m.getRuleBook(inputSize, outputSize, filterSize, filterStride, true);
   Int nActive = m.getNActive(outputSize);
   output_features.resize_({nActive, weight.size(2)});
@@ -45,27 +23,9 @@ double cpu_Convolution_updateOutput(
   else
     output_features.zero_();
 
-  double flops = 0;
-  auto ip = weight.size(1);
-  auto op = weight.size(2);
-  for (Int i = 0; i < (Int)_rules.size(); i++) {
-    auto r = _rules[i];
-    int nRules = r.size() / 2;
-    if (nRules) {
-      flops += nRules * ip * op;
-      // auto rt = torch::CPU(at_kINT).tensorFromBlob(&r[0], {nRules, 2});
-      // auto input_rows = input_features.index_select(0, rt.select(1, 0));
-      // auto w = weight.select(0, i);
-      // auto output_rows = at::mm(input_rows, w);
-      // output_features.index_add_(0, rt.select(1, 1), output_rows);
-      auto input_rows = input_features.type().tensor({nRules, ip});
-      rule_index_select<T>(input_rows, input_features, nRules, &r[0]);
-      auto w = weight.select(0, i);
-      auto output_rows = at::mm(input_rows, w);
-      rule_index_add_<T>(output_features, output_rows, nRules, &r[1]);
-    }
-  }
-  return flops;
+  return Convolution_ForwardPass<T>(
+      input_features.data<T>(), output_features.data<T>(), weight,
+      weight.size(1), weight.size(2), _rules, 0);
 }
 
 template <typename T, Int Dimension>
@@ -78,7 +38,7 @@ void cpu_Convolution_backward(
     /*float*/ at::Tensor d_output_features, /*float*/ at::Tensor weight,
     /*float*/ at::Tensor d_weight, /*float*/ at::Tensor d_bias) {
 
-  auto _rules =
+  auto &_rules =
       m.getRuleBook(inputSize, outputSize, filterSize, filterStride, true);
   Int nActive = m.getNActive(inputSize);
   d_input_features.resize_as_(input_features);
@@ -86,30 +46,11 @@ void cpu_Convolution_backward(
 
   if (nActive and d_bias.numel())
     at::sum_out(d_bias, d_output_features, {0}, false);
-  auto ip = weight.size(1);
-  auto op = weight.size(2);
-  for (Int i = 0; i < (Int)_rules.size(); i++) {
-    auto r = _rules[i];
-    int nRules = r.size() / 2;
-    if (nRules) {
-      auto w = weight.select(0, i);
-      auto dw = d_weight.select(0, i);
-      // auto rt = torch::CPU(at_kINT).tensorFromBlob(&r[0], {nRules, 2});
-      // auto input_rows = input_features.index_select(0, rt.select(1, 0));
-      // auto d_output_rows = d_output_features.index_select(0, rt.select(1,
-      // 1));
-      // at::mm_out(dw, input_rows.t(), d_output_rows);
-      // auto d_input_rows = at::mm(d_output_rows, w.t());
-      // d_input_features.index_add_(0, rt.select(1, 0), d_input_rows);
-      auto input_rows = input_features.type().tensor({nRules, ip});
-      rule_index_select<T>(input_rows, input_features, nRules, &r[0]);
-      auto d_output_rows = d_output_features.type().tensor({nRules, op});
-      rule_index_select<T>(d_output_rows, d_output_features, nRules, &r[1]);
-      at::mm_out(dw, input_rows.t(), d_output_rows);
-      auto d_input_rows = at::mm(d_output_rows, w.t());
-      rule_index_add_<T>(d_input_features, d_input_rows, nRules, &r[0]);
-    }
-  }
+  Convolution_BackwardPass<T>(input_features.data<T>(),
+                              d_input_features.data<T>(),
+                              d_output_features.data<T>(), weight,
+                              d_weight.data<T>(), weight.size(1),
+                              weight.size(2), _rules, 0);
 }
 
 template <typename T, Int Dimension>
@@ -119,7 +60,7 @@ double cpu_SubmanifoldConvolution_updateOutput(
     /*float*/ at::Tensor input_features, /*float*/ at::Tensor output_features,
     /*float*/ at::Tensor weight,
     /*float*/ at::Tensor bias) {
-  auto _rules = m.getSubmanifoldRuleBook(inputSize, filterSize, true);
+  auto &_rules = m.getSubmanifoldRuleBook(inputSize, filterSize, true);
   Int nActive = m.getNActive(inputSize);
   output_features.resize_({nActive, weight.size(2)});
   if (bias.numel() and nActive)
@@ -127,27 +68,9 @@ double cpu_SubmanifoldConvolution_updateOutput(
   else
     output_features.zero_();
 
-  double flops = 0;
-  auto ip = weight.size(1);
-  auto op = weight.size(2);
-  for (Int i = 0; i < (Int)_rules.size(); i++) {
-    auto r = _rules[i];
-    int nRules = r.size() / 2;
-    if (nRules) {
-      flops += nRules * ip * op;
-      // auto  rt = torch::CPU(at_kINT).tensorFromBlob(&r[0], {nRules, 2});
-      // auto input_rows = input_features.index_select(0, rt.select(1, 0));
-      // auto w = weight.select(0, i);
-      // auto output_rows = at::mm(input_rows, w);
-      // output_features.index_add_(0, rt.select(1, 1), output_rows);
-      auto input_rows = input_features.type().tensor({nRules, ip});
-      rule_index_select<T>(input_rows, input_features, nRules, &r[0]);
-      auto w = weight.select(0, i);
-      auto output_rows = at::mm(input_rows, w);
-      rule_index_add_<T>(output_features, output_rows, nRules, &r[1]);
-    }
-  }
-  return flops;
+  return Convolution_ForwardPass<T>(
+      input_features.data<T>(), output_features.data<T>(), weight,
+      weight.size(1), weight.size(2), _rules, 0);
 }
 
 template <typename T, Int Dimension>
@@ -160,37 +83,45 @@ void cpu_SubmanifoldConvolution_backward(
     /*float*/ at::Tensor d_weight,
     /*float*/ at::Tensor d_bias) {
 
-  auto _rules = m.getSubmanifoldRuleBook(inputSize, filterSize, true);
+  auto &_rules = m.getSubmanifoldRuleBook(inputSize, filterSize, true);
   Int nActive = m.getNActive(inputSize);
   d_input_features.resize_as_(input_features);
   d_input_features.zero_();
 
   if (nActive and d_bias.numel())
     at::sum_out(d_bias, d_output_features, {0}, false);
-  auto ip = weight.size(1);
-  auto op = weight.size(2);
-  for (Int i = 0; i < (Int)_rules.size(); i++) {
-    auto r = _rules[i];
-    int nRules = r.size() / 2;
-    if (nRules) {
-      auto w = weight.select(0, i);
-      auto dw = d_weight.select(0, i);
-      // auto rt = torch::CPU(at_kINT).tensorFromBlob(&r[0], {nRules, 2});
-      // auto input_rows = input_features.index_select(0, rt.select(1, 0));
-      // auto d_output_rows = d_output_features.index_select(0, rt.select(1,
-      // 1));
-      // at::mm_out(dw, input_rows.t(), d_output_rows);
-      // auto d_input_rows = at::mm(d_output_rows, w.t());
-      // d_input_features.index_add_(0, rt.select(1, 0), d_input_rows);
-      auto input_rows = input_features.type().tensor({nRules, ip});
-      rule_index_select<T>(input_rows, input_features, nRules, &r[0]);
-      auto d_output_rows = d_output_features.type().tensor({nRules, op});
-      rule_index_select<T>(d_output_rows, d_output_features, nRules, &r[1]);
-      at::mm_out(dw, input_rows.t(), d_output_rows);
-      auto d_input_rows = at::mm(d_output_rows, w.t());
-      rule_index_add_<T>(d_input_features, d_input_rows, nRules, &r[0]);
-    }
-  }
+  Convolution_BackwardPass<T>(input_features.data<T>(),
+                              d_input_features.data<T>(),
+                              d_output_features.data<T>(), weight,
+                              d_weight.data<T>(), weight.size(1),
+                              weight.size(2), _rules, 0);
+}
+
+// Output-stationary alternative to cpu_SubmanifoldConvolution_updateOutput,
+// driven by the submanifold neighbour table instead of the rulebook. The
+// backward pass is shared with the rulebook version.
+template <typename T, Int Dimension>
+double cpu_OutputStationarySubmanifoldConvolution_updateOutput(
+    /*long*/ at::Tensor inputSize, /*long*/ at::Tensor filterSize,
+    Metadata<Dimension> &m,
+    /*float*/ at::Tensor input_features, /*float*/ at::Tensor output_features,
+    /*float*/ at::Tensor weight,
+    /*float*/ at::Tensor bias) {
+  auto &neighbours =
+      m.getSubmanifoldNeighbourTable(inputSize, filterSize, true);
+  Int nActive = m.getNActive(inputSize);
+  Int fv = volume<Dimension>(filterSize.data<long>());
+  output_features.resize_({nActive, weight.size(2)});
+  if (bias.numel() and nActive)
+    output_features.copy_(bias);
+  else
+    output_features.zero_();
+
+  if (nActive)
+    SubmanifoldConvolution_OutputStationaryPass<T>(
+        input_features.data<T>(), output_features.data<T>(), weight.data<T>(),
+        weight.size(1), weight.size(2), neighbours, fv);
+  return (double)neighbours.nRules * weight.size(1) * weight.size(2);
 }
 
 template <typename T, Int Dimension>
@@ -202,8 +133,8 @@ double cpu_FullConvolution_updateOutput(
     /*float*/ at::Tensor input_features, /*float*/ at::Tensor output_features,
     /*float*/ at::Tensor weight,
     /*float*/ at::Tensor bias) {
-  auto _rules = mIn.getFullConvolutionRuleBook(inputSize, outputSize,
-                                               filterSize, filterStride, mOut);
+  auto &_rules = mIn.getFullConvolutionRuleBook(inputSize, outputSize,
+                                                filterSize, filterStride, mOut);
   Int nActive = mOut.getNActive(outputSize);
   output_features.resize_({nActive, weight.size(2)});
   if (bias.numel() and nActive)
@@ -211,27 +142,9 @@ double cpu_FullConvolution_updateOutput(
   else
     output_features.zero_();
 
-  double flops = 0;
-  auto ip = weight.size(1);
-  auto op = weight.size(2);
-  for (Int i = 0; i < (Int)_rules.size(); i++) {
-    auto r = _rules[i];
-    int nRules = r.size() / 2;
-    if (nRules) {
-      flops += nRules * ip * op;
-      // auto rt = torch::CPU(at_kINT).tensorFromBlob(&r[0], {nRules, 2});
-      // auto input_rows = input_features.index_select(0, rt.select(1, 0));
-      // auto w = weight.select(0, i);
-      // auto output_rows = at::mm(input_rows, w);
-      // output_features.index_add_(0, rt.select(1, 1), output_rows);
-      auto input_rows = input_features.type().tensor({nRules, ip});
-      rule_index_select<T>(input_rows, input_features, nRules, &r[0]);
-      auto w = weight.select(0, i);
-      auto output_rows = at::mm(input_rows, w);
-      rule_index_add_<T>(output_features, output_rows, nRules, &r[1]);
-    }
-  }
-  return flops;
+  return Convolution_ForwardPass<T>(
+      input_features.data<T>(), output_features.data<T>(), weight,
+      weight.size(1), weight.size(2), _rules, 0);
 }
 
 template <typename T, Int Dimension>
@@ -246,38 +159,19 @@ void cpu_FullConvolution_backward(
     /*float*/ at::Tensor d_weight,
     /*float*/ at::Tensor d_bias) {
 
-  auto _rules = mIn.getFullConvolutionRuleBook(inputSize, outputSize,
-                                               filterSize, filterStride, mOut);
+  auto &_rules = mIn.getFullConvolutionRuleBook(inputSize, outputSize,
+                                                filterSize, filterStride, mOut);
   Int nActive = mOut.getNActive(inputSize);
   d_input_features.resize_as_(input_features);
   d_input_features.zero_();
 
   if (nActive and d_bias.numel())
     at::sum_out(d_bias, d_output_features, {0}, false);
-  auto ip = weight.size(1);
-  auto op = weight.size(2);
-  for (Int i = 0; i < (Int)_rules.size(); i++) {
-    auto r = _rules[i];
-    int nRules = r.size() / 2;
-    if (nRules) {
-      auto w = weight.select(0, i);
-      auto dw = d_weight.select(0, i);
-      // auto rt = torch::CPU(at_kINT).tensorFromBlob(&r[0], {nRules, 2});
-      // auto input_rows = input_features.index_select(0, rt.select(1, 0));
-      // auto d_output_rows = d_output_features.index_select(0, rt.select(1,
-      // 1));
-      // at::mm_out(dw, input_rows.t(), d_output_rows);
-      // auto d_input_rows = at::mm(d_output_rows, w.t());
-      // d_input_features.index_add_(0, rt.select(1, 0), d_input_rows);
-      auto input_rows = input_features.type().tensor({nRules, ip});
-      rule_index_select<T>(input_rows, input_features, nRules, &r[0]);
-      auto d_output_rows = d_output_features.type().tensor({nRules, op});
-      rule_index_select<T>(d_output_rows, d_output_features, nRules, &r[1]);
-      at::mm_out(dw, input_rows.t(), d_output_rows);
-      auto d_input_rows = at::mm(d_output_rows, w.t());
-      rule_index_add_<T>(d_input_features, d_input_rows, nRules, &r[0]);
-    }
-  }
+  Convolution_BackwardPass<T>(input_features.data<T>(),
+                              d_input_features.data<T>(),
+                              d_output_features.data<T>(), weight,
+                              d_weight.data<T>(), weight.size(1),
+                              weight.size(2), _rules, 0);
 }
 
 template <typename T, Int Dimension>
@@ -288,8 +182,8 @@ double cpu_RandomizedStrideConvolution_updateOutput(
     /*float*/ at::Tensor input_features,
     /*float*/ at::Tensor output_features, /*float*/ at::Tensor weight,
     /*float*/ at::Tensor bias) {
-  auto _rules = m.getRandomizedStrideRuleBook(inputSize, outputSize, filterSize,
-                                              filterStride, true);
+  auto &_rules = m.getRandomizedStrideRuleBook(inputSize, outputSize,
+                                               filterSize, filterStride, true);
   Int nActive = m.getNActive(outputSize);
   output_features.resize_({nActive, weight.size(2)});
   if (bias.numel() and nActive)
@@ -297,27 +191,9 @@ double cpu_RandomizedStrideConvolution_updateOutput(
   else
     output_features.zero_();
 
-  double flops = 0;
-  auto ip = weight.size(1);
-  auto op = weight.size(2);
-  for (Int i = 0; i < (Int)_rules.size(); i++) {
-    auto r = _rules[i];
-    int nRules = r.size() / 2;
-    if (nRules) {
-      flops += nRules * ip * op;
-      // auto rt = torch::CPU(at_kINT).tensorFromBlob(&r[0], {nRules, 2});
-      // auto input_rows = input_features.index_select(0, rt.select(1, 0));
-      // auto w = weight.select(0, i);
-      // auto output_rows = at::mm(input_rows, w);
-      // output_features.index_add_(0, rt.select(1, 1), output_rows);
-      auto input_rows = input_features.type().tensor({nRules, ip});
-      rule_index_select<T>(input_rows, input_features, nRules, &r[0]);
-      auto w = weight.select(0, i);
-      auto output_rows = at::mm(input_rows, w);
-      rule_index_add_<T>(output_features, output_rows, nRules, &r[1]);
-    }
-  }
-  return flops;
+  return Convolution_ForwardPass<T>(
+      input_features.data<T>(), output_features.data<T>(), weight,
+      weight.size(1), weight.size(2), _rules, 0);
 }
 
 template <typename T, Int Dimension>
@@ -330,36 +206,17 @@ void cpu_RandomizedStrideConvolution_backward(
     /*float*/ at::Tensor d_output_features, /*float*/ at::Tensor weight,
     /*float*/ at::Tensor d_weight, /*float*/ at::Tensor d_bias) {
 
-  auto _rules = m.getRandomizedStrideRuleBook(inputSize, outputSize, filterSize,
-                                              filterStride, true);
+  auto &_rules = m.getRandomizedStrideRuleBook(inputSize, outputSize,
+                                               filterSize, filterStride, true);
   Int nActive = m.getNActive(inputSize);
   d_input_features.resize_as_(input_features);
   d_input_features.zero_();
 
   if (nActive and d_bias.numel())
     at::sum_out(d_bias, d_output_features, {0}, false);
-  auto ip = weight.size(1);
-  auto op = weight.size(2);
-  for (Int i = 0; i < (Int)_rules.size(); i++) {
-    auto r = _rules[i];
-    int nRules = r.size() / 2;
-    if (nRules) {
-      auto w = weight.select(0, i);
-      auto dw = d_weight.select(0, i);
-      // auto rt = torch::CPU(at_kINT).tensorFromBlob(&r[0], {nRules, 2});
-      // auto input_rows = input_features.index_select(0, rt.select(1, 0));
-      // auto d_output_rows = d_output_features.index_select(0, rt.select(1,
-      // 1));
-      // at::mm_out(dw, input_rows.t(), d_output_rows);
-      // auto d_input_rows = at::mm(d_output_rows, w.t());
-      // d_input_features.index_add_(0, rt.select(1, 0), d_input_rows);
-      auto input_rows = input_features.type().tensor({nRules, ip});
-      rule_index_select<T>(input_rows, input_features, nRules, &r[0]);
-      auto d_output_rows = d_output_features.type().tensor({nRules, op});
-      rule_index_select<T>(d_output_rows, d_output_features, nRules, &r[1]);
-      at::mm_out(dw, input_rows.t(), d_output_rows);
-      auto d_input_rows = at::mm(d_output_rows, w.t());
-      rule_index_add_<T>(d_input_features, d_input_rows, nRules, &r[0]);
-    }
-  }
+  Convolution_BackwardPass<T>(input_features.data<T>(),
+                              d_input_features.data<T>(),
+                              d_output_features.data<T>(), weight,
+                              d_weight.data<T>(), weight.size(1),
+                              weight.size(2), _rules, 0);
 }
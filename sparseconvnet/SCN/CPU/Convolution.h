@@ -0,0 +1,384 @@
+// Copyright 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef CPU_CONVOLUTION_H
+#define CPU_CONVOLUTION_H
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Fused gather-GEMM-scatter kernels for the rulebook driven convolutions.
+// The rules for a filter offset are processed convRowBlock at a time: the
+// rows they address are gathered into a small buffer that stays in cache,
+// multiplied by the weight matrix for the offset, and the products are added
+// straight into the destination rows. No temporary tensors are allocated.
+//
+// Each rule is an (input row, output row) pair; inCol selects which half of
+// the pair addresses the rows being read (0 for convolutions, 1 for
+// deconvolutions).
+//
+// The micro-kernel only pays off while the weight matrix of an offset is
+// small. With at least convMmPlanes input and output planes, the gathered
+// blocks are multiplied with at::mm instead, and the products are then added
+// to the destination rows.
+
+// Rules per block, and the register tile of the micro-kernel
+const Int convRowBlock = 64;
+const Int convTileRows = 4;
+const Int convTileCols = 16;
+const Int convMmPlanes = 32;
+
+inline bool Convolution_useMm(Int ip, Int op) {
+  return std::min(ip, op) >= convMmPlanes;
+}
+
+// Per-thread scratch space, reused across filter offsets and blocks
+template <typename T> class ConvolutionBuffers {
+public:
+  std::vector<T> a, b;
+  std::vector<T *> c, dwRows;
+  // For at::mm: the gathered blocks, and the products
+  at::Tensor ta, tb, tc, td, tdw;
+  void reserve(Int ip, Int op) {
+    a.resize(convRowBlock * ip);
+    b.resize(convRowBlock * op);
+    c.resize(convRowBlock);
+    dwRows.resize(ip);
+    scratchBytes() += sizeof(T) * (a.size() + b.size()) +
+                      sizeof(T *) * (c.size() + dwRows.size());
+  }
+  void reserveMm(const at::Tensor &weight, Int ip, Int op) {
+    ta = weight.type().tensor({convRowBlock, ip});
+    tb = weight.type().tensor({convRowBlock, op});
+    tc = weight.type().tensor({convRowBlock, op});
+    td = weight.type().tensor({convRowBlock, ip});
+    tdw = weight.type().tensor({ip, op});
+    c.resize(convRowBlock);
+    dwRows.resize(ip);
+    scratchBytes() += sizeof(T) * (2 * convRowBlock * (ip + op) + ip * op) +
+                      sizeof(T *) * (c.size() + dwRows.size());
+  }
+};
+
+// c[r][j] += sum_k a[r * rs + k * ks] * b[k * ldb + j]
+// for r < MR and j < n; MR and convTileCols are fixed so that the
+// accumulators can live in vector registers.
+template <typename T, Int MR>
+void Convolution_microKernel(const T *a, Int rs, Int ks, const T *b, Int ldb,
+                             Int K, T **c, Int n) {
+  for (Int j0 = 0; j0 < n; j0 += convTileCols) {
+    Int nc = std::min(convTileCols, n - j0);
+    T acc[MR][convTileCols];
+    for (Int r = 0; r < MR; r++)
+      for (Int j = 0; j < convTileCols; j++)
+        acc[r][j] = 0;
+    if (nc == convTileCols) {
+      for (Int k = 0; k < K; k++) {
+        const T *bk = b + k * ldb + j0;
+        for (Int r = 0; r < MR; r++) {
+          T ark = a[r * rs + k * ks];
+          for (Int j = 0; j < convTileCols; j++)
+            acc[r][j] += ark * bk[j];
+        }
+      }
+    } else {
+      for (Int k = 0; k < K; k++) {
+        const T *bk = b + k * ldb + j0;
+        for (Int r = 0; r < MR; r++) {
+          T ark = a[r * rs + k * ks];
+          for (Int j = 0; j < nc; j++)
+            acc[r][j] += ark * bk[j];
+        }
+      }
+    }
+    for (Int r = 0; r < MR; r++)
+      for (Int j = 0; j < nc; j++)
+        c[r][j0 + j] += acc[r][j];
+  }
+}
+
+// c[r][0:N] += A[r] * b for r < nRows, with A[r][k] = a[r * rs + k * ks] and
+// b a K x N row-major matrix
+template <typename T>
+void Convolution_gemm(const T *a, Int rs, Int ks, Int nRows, const T *b, Int K,
+                      Int N, T **c) {
+  Int r = 0;
+  for (; r + convTileRows <= nRows; r += convTileRows)
+    Convolution_microKernel<T, convTileRows>(a + r * rs, rs, ks, b, N, K,
+                                             c + r, N);
+  for (; r < nRows; r++)
+    Convolution_microKernel<T, 1>(a + r * rs, rs, ks, b, N, K, c + r, N);
+}
+
+// Copy the rule[col] rows of src into buf
+template <typename T>
+void Convolution_gather(const T *src, Int planes, T *buf, const Int *rules,
+                        Int n, Int col) {
+  for (Int j = 0; j < n; j++)
+    std::memcpy(buf + j * planes, src + (long)rules[2 * j + col] * planes,
+                sizeof(T) * planes);
+}
+
+// Point dst at the rule[col] rows of target
+template <typename T>
+void Convolution_rows(T *target, Int planes, T **dst, const Int *rules, Int n,
+                      Int col) {
+  for (Int j = 0; j < n; j++)
+    dst[j] = target + (long)rules[2 * j + col] * planes;
+}
+
+// output_features[out] += input_features[in] * w for a block of n rules
+template <typename T>
+void Convolution_fpBlock(const T *input_features, T *output_features,
+                         const T *w, Int ip, Int op, const Int *rules, Int n,
+                         Int inCol, ConvolutionBuffers<T> &buf) {
+  Convolution_gather<T>(input_features, ip, &buf.a[0], rules, n, inCol);
+  Convolution_rows<T>(output_features, op, &buf.c[0], rules, n, 1 - inCol);
+  Convolution_gemm<T>(&buf.a[0], ip, 1, n, w, ip, op, &buf.c[0]);
+}
+
+// c[r][0:N] += p[r][0:N] for r < nRows, with p row-major
+template <typename T>
+void Convolution_addRows(const T *p, Int nRows, Int N, T **c) {
+  for (Int r = 0; r < nRows; r++) {
+    const T *pr = p + r * N;
+    T *cr = c[r];
+    for (Int j = 0; j < N; j++)
+      cr[j] += pr[j];
+  }
+}
+
+// Convolution_fpBlock with at::mm; w is the ip x op weight tensor
+template <typename T>
+void Convolution_fpBlockMm(const T *input_features, T *output_features,
+                           at::Tensor w, Int ip, Int op, const Int *rules,
+                           Int n, Int inCol, ConvolutionBuffers<T> &buf) {
+  Convolution_gather<T>(input_features, ip, buf.ta.template data<T>(), rules,
+                        n, inCol);
+  Convolution_rows<T>(output_features, op, &buf.c[0], rules, n, 1 - inCol);
+  auto c = buf.tc.narrow(0, 0, n);
+  at::mm_out(c, buf.ta.narrow(0, 0, n), w);
+  Convolution_addRows<T>(c.template data<T>(), n, op, &buf.c[0]);
+}
+
+// For a block of n rules:
+//   d_input_features[in] += d_output_features[out] * w^T
+//   dw += input_features[in]^T * d_output_features[out]
+// Both products share one gather of the input and d_output rows.
+template <typename T>
+void Convolution_bpBlock(const T *input_features, T *d_input_features,
+                         const T *d_output_features, const T *wT, T **dwRows,
+                         Int ip, Int op, const Int *rules, Int n, Int inCol,
+                         ConvolutionBuffers<T> &buf) {
+  Convolution_gather<T>(input_features, ip, &buf.a[0], rules, n, inCol);
+  Convolution_gather<T>(d_output_features, op, &buf.b[0], rules, n, 1 - inCol);
+  Convolution_rows<T>(d_input_features, ip, &buf.c[0], rules, n, inCol);
+  // dw (ip x op) += a^T (ip x n) * b (n x op)
+  Convolution_gemm<T>(&buf.a[0], 1, ip, ip, &buf.b[0], n, op, dwRows);
+  // d_input rows (n x ip) += b (n x op) * w^T (op x ip)
+  Convolution_gemm<T>(&buf.b[0], op, 1, n, wT, op, ip, &buf.c[0]);
+}
+
+// Convolution_bpBlock with at::mm; w is the ip x op weight tensor
+template <typename T>
+void Convolution_bpBlockMm(const T *input_features, T *d_input_features,
+                           const T *d_output_features, at::Tensor w,
+                           T **dwRows, Int ip, Int op, const Int *rules, Int n,
+                           Int inCol, ConvolutionBuffers<T> &buf) {
+  Convolution_gather<T>(input_features, ip, buf.ta.template data<T>(), rules,
+                        n, inCol);
+  Convolution_gather<T>(d_output_features, op, buf.tb.template data<T>(),
+                        rules, n, 1 - inCol);
+  Convolution_rows<T>(d_input_features, ip, &buf.c[0], rules, n, inCol);
+  auto a = buf.ta.narrow(0, 0, n), b = buf.tb.narrow(0, 0, n);
+  at::mm_out(buf.tdw, a.t(), b);
+  Convolution_addRows<T>(buf.tdw.template data<T>(), ip, op, dwRows);
+  auto d = buf.td.narrow(0, 0, n);
+  at::mm_out(d, b, w.t());
+  Convolution_addRows<T>(d.template data<T>(), n, ip, &buf.c[0]);
+}
+
+// Parallel schedule: within one filter offset no two rules share an input row
+// or an output row, so the blocks of an offset can be processed concurrently
+// without write conflicts. The offsets are taken one after the other, so each
+// row receives its contributions in the same order whatever the number of
+// threads. The weight gradient for an offset is summed over up to
+// convWeightChunks fixed chunks of blocks, and the partial sums are added up in
+// chunk order, so it is deterministic too.
+const Int convWeightChunks = 64;
+
+// output_features[out] += input_features[in] * weight[k] for every rule of
+// every filter offset k; weight is filterVolume x ip x op
+template <typename T>
+double Convolution_ForwardPass(const T *input_features, T *output_features,
+                               at::Tensor weight, Int ip, Int op,
+                               const RuleBook &rules, Int inCol) {
+  bool mm = Convolution_useMm(ip, op);
+#pragma omp parallel
+  {
+    ConvolutionBuffers<T> buf;
+    if (mm)
+      buf.reserveMm(weight, ip, op);
+    else
+      buf.reserve(ip, op);
+    for (Int i = 0; i < rules.size(); i++) {
+      Int nRules = rules.nRules(i);
+      Int nBlocks = (nRules + convRowBlock - 1) / convRowBlock;
+      auto w = weight.select(0, i);
+#pragma omp for schedule(dynamic)
+      for (Int b = 0; b < nBlocks; b++) {
+        const Int *r = rules[i] + 2 * b * convRowBlock;
+        Int n = std::min(convRowBlock, nRules - b * convRowBlock);
+        if (mm)
+          Convolution_fpBlockMm<T>(input_features, output_features, w, ip, op,
+                                   r, n, inCol, buf);
+        else
+          Convolution_fpBlock<T>(input_features, output_features,
+                                 w.template data<T>(), ip, op, r, n, inCol,
+                                 buf);
+      }
+    }
+  }
+  return (double)rules.nRules() * ip * op;
+}
+
+// The backward pass of Convolution_ForwardPass; d_weight is accumulated into
+template <typename T>
+void Convolution_BackwardPass(const T *input_features, T *d_input_features,
+                              const T *d_output_features, at::Tensor weight,
+                              T *d_weight, Int ip, Int op,
+                              const RuleBook &rules, Int inCol) {
+  bool mm = Convolution_useMm(ip, op);
+  std::vector<T> wT(ip * op), partial(convWeightChunks * ip * op);
+  scratchBytes() += sizeof(T) * (wT.size() + partial.size());
+#pragma omp parallel
+  {
+    ConvolutionBuffers<T> buf;
+    if (mm)
+      buf.reserveMm(weight, ip, op);
+    else
+      buf.reserve(ip, op);
+    for (Int i = 0; i < rules.size(); i++) {
+      Int nRules = rules.nRules(i);
+      if (nRules == 0)
+        continue;
+      Int nBlocks = (nRules + convRowBlock - 1) / convRowBlock;
+      Int nChunks = std::min(nBlocks, convWeightChunks);
+      auto w = weight.select(0, i);
+      T *dw = d_weight + (long)i * ip * op;
+      // w^T, so that the micro-kernel runs along the rows of d_input_features
+      if (not mm) {
+        const T *wp = w.template data<T>();
+#pragma omp for
+        for (Int j = 0; j < ip * op; j++)
+          wT[(j % op) * ip + j / op] = wp[j];
+      }
+#pragma omp for schedule(dynamic)
+      for (Int c = 0; c < nChunks; c++) {
+        T *p = &partial[(long)c * ip * op];
+        std::fill(p, p + ip * op, 0);
+        for (Int k = 0; k < ip; k++)
+          buf.dwRows[k] = p + k * op;
+        for (Int b = c * nBlocks / nChunks; b < (c + 1) * nBlocks / nChunks;
+             b++) {
+          const Int *r = rules[i] + 2 * b * convRowBlock;
+          Int n = std::min(convRowBlock, nRules - b * convRowBlock);
+          if (mm)
+            Convolution_bpBlockMm<T>(input_features, d_input_features,
+                                     d_output_features, w, &buf.dwRows[0], ip,
+                                     op, r, n, inCol, buf);
+          else
+            Convolution_bpBlock<T>(input_features, d_input_features,
+                                   d_output_features, &wT[0], &buf.dwRows[0],
+                                   ip, op, r, n, inCol, buf);
+        }
+      }
+#pragma omp for
+      for (Int j = 0; j < ip * op; j++)
+        for (Int c = 0; c < nChunks; c++)
+          dw[j] += partial[(long)c * ip * op + j];
+    }
+  }
+}
+// Output-stationary submanifold convolution. For MR consecutive output rows,
+// starting at output_features, accumulate the contributions of all the filter
+// offsets in registers and add them to the output once; neighbours holds the
+// MR rows of the neighbour table. Offsets with no active neighbour in any of
+// the MR rows are skipped; otherwise missing neighbours read from zeros.
+template <typename T, Int MR>
+void SubmanifoldConvolution_microKernel(const T *input_features,
+                                        T *output_features, const T *weight,
+                                        const Int *neighbours, Int fv, Int ip,
+                                        Int op, const T *zeros) {
+  for (Int j0 = 0; j0 < op; j0 += convTileCols) {
+    Int nc = std::min(convTileCols, op - j0);
+    T acc[MR][convTileCols];
+    for (Int r = 0; r < MR; r++)
+      for (Int j = 0; j < convTileCols; j++)
+        acc[r][j] = 0;
+    for (Int k = 0; k < fv; k++) {
+      const T *a[MR];
+      bool active = false;
+      for (Int r = 0; r < MR; r++) {
+        Int n = neighbours[r * fv + k];
+        a[r] = n < 0 ? zeros : input_features + (long)n * ip;
+        active = active or n >= 0;
+      }
+      if (not active)
+        continue;
+      const T *w = weight + (long)k * ip * op + j0;
+      if (nc == convTileCols) {
+        for (Int l = 0; l < ip; l++) {
+          const T *bl = w + l * op;
+          for (Int r = 0; r < MR; r++) {
+            T arl = a[r][l];
+            for (Int j = 0; j < convTileCols; j++)
+              acc[r][j] += arl * bl[j];
+          }
+        }
+      } else {
+        for (Int l = 0; l < ip; l++) {
+          const T *bl = w + l * op;
+          for (Int r = 0; r < MR; r++) {
+            T arl = a[r][l];
+            for (Int j = 0; j < nc; j++)
+              acc[r][j] += arl * bl[j];
+          }
+        }
+      }
+    }
+    for (Int r = 0; r < MR; r++)
+      for (Int j = 0; j < nc; j++)
+        output_features[r * op + j0 + j] += acc[r][j];
+  }
+}
+
+// output_features[j] += sum_k input_features[neighbours[j][k]] * weight[k]
+// Each output row is written by exactly one thread, once.
+template <typename T>
+void SubmanifoldConvolution_OutputStationaryPass(
+    const T *input_features, T *output_features, const T *weight, Int ip,
+    Int op, const NeighbourTable &neighbours, Int fv) {
+  Int nActive = neighbours.size() / fv;
+  Int nBlocks = (nActive + convTileRows - 1) / convTileRows;
+  std::vector<T> zeros(ip, 0);
+  scratchBytes() += sizeof(T) * ip;
+  Int b;
+#pragma omp parallel for private(b)
+  for (b = 0; b < nBlocks; b++) {
+    Int j = b * convTileRows;
+    if (j + convTileRows <= nActive)
+      SubmanifoldConvolution_microKernel<T, convTileRows>(
+          input_features, output_features + (long)j * op, weight,
+          &neighbours[(long)j * fv], fv, ip, op, &zeros[0]);
+    else
+      for (; j < nActive; j++)
+        SubmanifoldConvolution_microKernel<T, 1>(
+            input_features, output_features + (long)j * op, weight,
+            &neighbours[(long)j * fv], fv, ip, op, &zeros[0]);
+  }
+}
+#endif /* CPU_CONVOLUTION_H */
@@ -15,7 +15,7 @@ void cpu_MaxPooling_updateOutput(
     /*float*/ at::Tensor output_features, long nFeaturesToDrop) {
 
   Int nPlanes = input_features.size(1) - nFeaturesToDrop;
-  auto _rules =
+  auto &_rules =
       m.getRuleBook(inputSize, outputSize, poolSize, poolStride, true);
   Int nActive = m.getNActive(outputSize);
   output_features.resize_({nActive, input_features.size(1) - nFeaturesToDrop});
@@ -24,10 +24,10 @@ void cpu_MaxPooling_updateOutput(
   auto iF = input_features.data<T>() + nFeaturesToDrop;
   auto oF = output_features.data<T>();
 
-  for (auto &r : _rules) {
-    Int nHot = r.size() / 2;
+  for (Int k = 0; k < _rules.size(); k++) {
+    Int nHot = _rules.nRules(k);
     MaxPooling_ForwardPass<T>(iF, oF, nPlanes, input_features.stride(0),
-                              output_features.stride(0), &r[0], nHot);
+                              output_features.stride(0), _rules[k], nHot);
   }
 }
 template <typename T, Int Dimension>
@@ -40,7 +40,7 @@ void cpu_MaxPooling_updateGradInput(
     /*float*/ at::Tensor d_output_features, long nFeaturesToDrop) {
 
   Int nPlanes = input_features.size(1) - nFeaturesToDrop;
-  auto _rules =
+  auto &_rules =
       m.getRuleBook(inputSize, outputSize, poolSize, poolStride, true);
   d_input_features.resize_as_(input_features);
   d_input_features.zero_();
@@ -50,11 +50,11 @@ void cpu_MaxPooling_updateGradInput(
   auto diF = d_input_features.data<T>();
   auto doF = d_output_features.data<T>();
 
-  for (auto &r : _rules) {
-    Int nHot = r.size() / 2;
+  for (Int k = 0; k < _rules.size(); k++) {
+    Int nHot = _rules.nRules(k);
     MaxPooling_BackwardPass<T>(iF, diF, oF, doF, nPlanes,
                                input_features.stride(0),
-                               output_features.stride(0), &r[0], nHot);
+                               output_features.stride(0), _rules[k], nHot);
   }
 }
 template <typename T, Int Dimension>
@@ -66,8 +66,8 @@ void cpu_RandomizedStrideMaxPooling_updateOutput(
     /*float*/ at::Tensor output_features, long nFeaturesToDrop) {
 
   Int nPlanes = input_features.size(1) - nFeaturesToDrop;
-  auto _rules = m.getRandomizedStrideRuleBook(inputSize, outputSize, poolSize,
-                                              poolStride, true);
+  auto &_rules = m.getRandomizedStrideRuleBook(inputSize, outputSize, poolSize,
+                                               poolStride, true);
   Int nActive = m.getNActive(outputSize);
   output_features.resize_({nActive, input_features.size(1) - nFeaturesToDrop});
   output_features.zero_();
@@ -75,10 +75,10 @@ void cpu_RandomizedStrideMaxPooling_updateOutput(
   auto iF = input_features.data<T>() + nFeaturesToDrop;
   auto oF = output_features.data<T>();
 
-  for (auto &r : _rules) {
-    Int nHot = r.size() / 2;
+  for (Int k = 0; k < _rules.size(); k++) {
+    Int nHot = _rules.nRules(k);
     MaxPooling_ForwardPass<T>(iF, oF, nPlanes, input_features.stride(0),
-                              output_features.stride(0), &r[0], nHot);
+                              output_features.stride(0), _rules[k], nHot);
   }
 }
 template <typename T, Int Dimension>
@@ -91,8 +91,8 @@ void cpu_RandomizedStrideMaxPooling_updateGradInput(
     /*float*/ at::Tensor d_output_features, long nFeaturesToDrop) {
 
   Int nPlanes = input_features.size(1) - nFeaturesToDrop;
-  auto _rules = m.getRandomizedStrideRuleBook(inputSize, outputSize, poolSize,
-                                              poolStride, true);
+  auto &_rules = m.getRandomizedStrideRuleBook(inputSize, outputSize, poolSize,
+                                               poolStride, true);
   d_input_features.resize_as_(input_features);
   d_input_features.zero_();
 
@@ -101,10 +101,10 @@ void cpu_RandomizedStrideMaxPooling_updateGradInput(
   auto diF = d_input_features.data<T>();
   auto doF = d_output_features.data<T>();
 
-  for (auto &r : _rules) {
-    Int nHot = r.size() / 2;
+  for (Int k = 0; k < _rules.size(); k++) {
+    Int nHot = _rules.nRules(k);
     MaxPooling_BackwardPass<T>(iF, diF, oF, doF, nPlanes,
                                input_features.stride(0),
-                               output_features.stride(0), &r[0], nHot);
+                               output_features.stride(0), _rules[k], nHot);
   }
 }
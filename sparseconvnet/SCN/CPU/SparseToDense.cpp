@@ -23,14 +23,14 @@ void cpu_SparseToDense_updateOutput(
     output_features.zero_();
   }
   if (input_features.ndimension() == 2) {
-    auto _rules = m.getSparseToDenseRuleBook(inputSize, true);
+    auto &_rules = m.getSparseToDenseRuleBook(inputSize, true);
     Int _nPlanes = input_features.size(1);
     auto iF = input_features.data<T>();
     auto oF = output_features.data<T>();
     long spatialVolume = inputSize.prod().data<long>()[0];
-    for (auto &r : _rules) {
-      Int nHot = r.size() / 2;
-      SparseToDense_ForwardPass<T>(iF, oF, _nPlanes, spatialVolume, &r[0],
+    for (Int k = 0; k < _rules.size(); k++) {
+      Int nHot = _rules.nRules(k);
+      SparseToDense_ForwardPass<T>(iF, oF, _nPlanes, spatialVolume, _rules[k],
                                    nHot);
       oF += _nPlanes * spatialVolume;
     }
@@ -46,15 +46,15 @@ void cpu_SparseToDense_updateGradInput(
   d_input_features.resize_as_(input_features);
   d_input_features.zero_();
   if (input_features.ndimension() == 2) {
-    auto _rules = m.getSparseToDenseRuleBook(inputSize, true);
+    auto &_rules = m.getSparseToDenseRuleBook(inputSize, true);
     long spatialVolume = inputSize.prod().data<long>()[0];
     Int _nPlanes = d_input_features.size(1);
     auto diF = d_input_features.data<T>();
     auto doF = d_output_features.data<T>();
-    for (auto &r : _rules) {
-      Int nHot = r.size() / 2;
-      SparseToDense_BackwardPass<T>(diF, doF, _nPlanes, spatialVolume, &r[0],
-                                    nHot);
+    for (Int k = 0; k < _rules.size(); k++) {
+      Int nHot = _rules.nRules(k);
+      SparseToDense_BackwardPass<T>(diF, doF, _nPlanes, spatialVolume,
+                                    _rules[k], nHot);
       doF += _nPlanes * spatialVolume;
     }
   }
@@ -13,7 +13,7 @@ void cuda_ActivePooling_updateOutput(
     /*cuda float*/ at::Tensor output_features, bool average) {
 
   Int nPlanes = input_features.size(1);
-  auto _rules = m.getActivePoolingRuleBook(inputSize);
+  auto &_rules = m.getActivePoolingRuleBook(inputSize);
   Int batchSize = _rules[1][0];
   Int maxActive = _rules[1][1];
   output_features.resize_({batchSize, nPlanes});
@@ -43,7 +43,7 @@ void cuda_ActivePooling_updateGradInput(
     /*cuda float*/ at::Tensor d_output_features, bool average) {
 
   Int nPlanes = input_features.size(1);
-  auto _rules = m.getActivePoolingRuleBook(inputSize);
+  auto &_rules = m.getActivePoolingRuleBook(inputSize);
   Int batchSize = _rules[1][0];
   Int maxActive = _rules[1][1];
   d_input_features.resize_as_(input_features);
@@ -16,7 +16,7 @@ double cuda_Convolution_updateOutput(
     /*cuda float*/ at::Tensor output_features, /*cuda float*/ at::Tensor weight,
     /*cuda float*/ at::Tensor bias) {
 
-  auto _rules =
+  auto &_rules =
       m.getRuleBook(inputSize, outputSize, filterSize, filterStride, true);
   Int nActive = m.getNActive(outputSize);
   output_features.resize_({nActive, weight.size(2)});
@@ -59,7 +59,7 @@ void cuda_Convolution_backward(
     /*cuda float*/ at::Tensor weight, /*cuda float*/ at::Tensor d_weight,
     /*cuda float*/ at::Tensor d_bias) {
 
-  auto _rules =
+  auto &_rules =
       m.getRuleBook(inputSize, outputSize, filterSize, filterStride, true);
   Int nActive = m.getNActive(outputSize);
   d_input_features.resize_as_(input_features);
@@ -93,7 +93,7 @@ double cuda_SubmanifoldConvolution_updateOutput(
     /*cuda float*/ at::Tensor output_features, /*cuda float*/ at::Tensor weight,
     /*cuda float*/ at::Tensor bias) {
 
-  auto _rules = m.getSubmanifoldRuleBook(inputSize, filterSize, true);
+  auto &_rules = m.getSubmanifoldRuleBook(inputSize, filterSize, true);
   Int nActive = m.getNActive(inputSize);
   output_features.resize_({nActive, weight.size(2)});
   if (bias.numel() and nActive)
@@ -136,7 +136,7 @@ void cuda_SubmanifoldConvolution_backward(
     /*cuda float*/ at::Tensor weight, /*cuda float*/ at::Tensor d_weight,
     /*cuda float*/ at::Tensor d_bias) {
 
-  auto _rules = m.getSubmanifoldRuleBook(inputSize, filterSize, true);
+  auto &_rules = m.getSubmanifoldRuleBook(inputSize, filterSize, true);
   Int nActive = m.getNActive(inputSize);
   d_input_features.resize_as_(input_features);
   d_input_features.zero_();
@@ -171,8 +171,8 @@ double cuda_FullConvolution_updateOutput(
     /*cuda float*/ at::Tensor output_features, /*cuda float*/ at::Tensor weight,
     /*cuda float*/ at::Tensor bias) {
 
-  auto _rules = mIn.getFullConvolutionRuleBook(inputSize, outputSize,
-                                               filterSize, filterStride, mOut);
+  auto &_rules = mIn.getFullConvolutionRuleBook(inputSize, outputSize,
+                                                filterSize, filterStride, mOut);
   Int nActive = mOut.getNActive(outputSize);
   output_features.resize_({nActive, weight.size(2)});
   if (not bias.numel())
@@ -215,8 +215,8 @@ void cuda_FullConvolution_backward(
     /*cuda float*/ at::Tensor weight, /*cuda float*/ at::Tensor d_weight,
     /*cuda float*/ at::Tensor d_bias) {
 
-  auto _rules = mIn.getFullConvolutionRuleBook(inputSize, outputSize,
-                                               filterSize, filterStride, mOut);
+  auto &_rules = mIn.getFullConvolutionRuleBook(inputSize, outputSize,
+                                                filterSize, filterStride, mOut);
   Int nActive = mOut.getNActive(outputSize);
   d_input_features.resize_as_(input_features);
   d_input_features.zero_();
@@ -248,8 +248,8 @@ double cuda_RandomizedStrideConvolution_updateOutput(
     /*cuda float*/ at::Tensor output_features,
     /*cuda float*/ at::Tensor weight, /*cuda float*/ at::Tensor bias) {
 
-  auto _rules = m.getRandomizedStrideRuleBook(inputSize, outputSize, filterSize,
-                                              filterStride, true);
+  auto &_rules = m.getRandomizedStrideRuleBook(inputSize, outputSize,
+                                               filterSize, filterStride, true);
   Int nActive = m.getNActive(outputSize);
   output_features.resize_({nActive, weight.size(2)});
   if (not bias.numel())
@@ -291,8 +291,8 @@ void cuda_RandomizedStrideConvolution_backward(
     /*cuda float*/ at::Tensor weight, /*cuda float*/ at::Tensor d_weight,
     /*cuda float*/ at::Tensor d_bias) {
 
-  auto _rules = m.getRandomizedStrideRuleBook(inputSize, outputSize, filterSize,
-                                              filterStride, true);
+  auto &_rules = m.getRandomizedStrideRuleBook(inputSize, outputSize,
+                                               filterSize, filterStride, true);
   Int nActive = m.getNActive(outputSize);
   d_input_features.resize_as_(input_features);
   d_input_features.zero_();
@@ -16,7 +16,7 @@ double cuda_Deconvolution_updateOutput(
     /*cuda float*/ at::Tensor output_features, /*cuda float*/ at::Tensor weight,
     /*cuda float*/ at::Tensor bias) {
 
-  auto _rules =
+  auto &_rules =
       m.getRuleBook(outputSize, inputSize, filterSize, filterStride, true);
   Int nActive = m.getNActive(outputSize);
   output_features.resize_({nActive, weight.size(2)});
@@ -57,7 +57,7 @@ void cuda_Deconvolution_backward(
     /*cuda float*/ at::Tensor weight, /*cuda float*/ at::Tensor d_weight,
     /*cuda float*/ at::Tensor d_bias) {
 
-  auto _rules =
+  auto &_rules =
       m.getRuleBook(outputSize, inputSize, filterSize, filterStride, true);
   Int nActive = m.getNActive(outputSize);
   d_input_features.resize_as_(input_features);
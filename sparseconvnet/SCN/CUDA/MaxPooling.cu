@@ -16,7 +16,7 @@ void cuda_MaxPooling_updateOutput(
     /*cuda float*/ at::Tensor output_features, long nFeaturesToDrop) {
 
   Int nPlanes = input_features.size(1) - nFeaturesToDrop;
-  auto _rules =
+  auto &_rules =
       m.getRuleBook(inputSize, outputSize, poolSize, poolStride, true);
   Int nActive = m.getNActive(outputSize);
   output_features.resize_({nActive, nPlanes});
@@ -40,7 +40,7 @@ void cuda_MaxPooling_updateGradInput(
     /*cuda float*/ at::Tensor d_output_features, long nFeaturesToDrop) {
 
   Int nPlanes = input_features.size(1) - nFeaturesToDrop;
-  auto _rules =
+  auto &_rules =
       m.getRuleBook(inputSize, outputSize, poolSize, poolStride, true);
   d_input_features.resize_as_(input_features);
   d_input_features.zero_();
@@ -63,8 +63,8 @@ void cuda_RandomizedStrideMaxPooling_updateOutput(
     /*cuda float*/ at::Tensor output_features, long nFeaturesToDrop) {
 
   Int nPlanes = input_features.size(1) - nFeaturesToDrop;
-  auto _rules = m.getRandomizedStrideRuleBook(inputSize, outputSize, poolSize,
-                                              poolStride, true);
+  auto &_rules = m.getRandomizedStrideRuleBook(inputSize, outputSize, poolSize,
+                                               poolStride, true);
   Int nActive = m.getNActive(outputSize);
   output_features.resize_({nActive, nPlanes});
   output_features.zero_();
@@ -87,8 +87,8 @@ void cuda_RandomizedStrideMaxPooling_updateGradInput(
     /*cuda float*/ at::Tensor d_output_features, long nFeaturesToDrop) {
 
   Int nPlanes = input_features.size(1) - nFeaturesToDrop;
-  auto _rules = m.getRandomizedStrideRuleBook(inputSize, outputSize, poolSize,
-                                              poolStride, true);
+  auto &_rules = m.getRandomizedStrideRuleBook(inputSize, outputSize, poolSize,
+                                               poolStride, true);
   d_input_features.resize_as_(input_features);
   d_input_features.zero_();
 
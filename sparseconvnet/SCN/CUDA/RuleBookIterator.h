@@ -9,22 +9,23 @@
 
 // Macro to parallelize loading rulebook elements to CUDA memory and operating
 // on the elements of the rulebook.
+// The whole (compact) rulebook is copied to the GPU in one go; rbB points at
+// the nHotB rules for the current filter offset.
 // X is the function to apply.
 // Y is a command to run
 
 #define RULEBOOKITERATOR(X, Y)                                                 \
   {                                                                            \
-    Int rbMaxSize = 0;                                                        \
-    for (auto &r : _rules)                                                     \
-      rbMaxSize = std::max(rbMaxSize, (Int)r.size());                         \
-    at::Tensor rulesBuffer = at::CUDA(at_kINT).tensor({rbMaxSize});            \
-    Int *rbB = rulesBuffer.data<Int>();                                       \
+    Int rbSize = 2 * _rules.nRules();                                          \
+    at::Tensor rulesBuffer = at::CUDA(at_kINT).tensor({rbSize});               \
+    Int *rbB0 = rulesBuffer.data<Int>();                                       \
+    if (rbSize)                                                                \
+      cudaMemcpy(rbB0, _rules.data(), sizeof(Int) * rbSize,                    \
+                 cudaMemcpyHostToDevice);                                      \
     for (int k = 0; k < _rules.size(); ++k) {                                  \
-      auto &r = _rules[k];                                                     \
-      Int nHotB = r.size() / 2;                                               \
+      Int *rbB = rbB0 + 2 * _rules.offsets[k];                                 \
+      Int nHotB = _rules.nRules(k);                                            \
       if (nHotB) {                                                             \
-        cudaMemcpy(rbB, &r[0], sizeof(Int) * 2 * nHotB,                       \
-                   cudaMemcpyHostToDevice);                                    \
         X                                                                      \
       }                                                                        \
       Y                                                                        \
@@ -23,7 +23,7 @@ void cuda_SparseToDense_updateOutput(
     output_features.zero_();
   }
   if (input_features.ndimension() == 2) {
-    auto _rules = m.getSparseToDenseRuleBook(inputSize, true);
+    auto &_rules = m.getSparseToDenseRuleBook(inputSize, true);
     Int _nPlanes = input_features.size(1);
     auto iF = input_features.data<T>();
     auto oF = output_features.data<T>();
@@ -44,7 +44,7 @@ void cuda_SparseToDense_updateGradInput(
   d_input_features.zero_();
 
   if (input_features.ndimension() == 2) {
-    auto _rules = m.getSparseToDenseRuleBook(inputSize, true);
+    auto &_rules = m.getSparseToDenseRuleBook(inputSize, true);
     long spatialVolume = inputSize.prod().data<long>()[0];
     Int _nPlanes = d_input_features.size(1);
     auto diF = d_input_features.data<T>();
@@ -5,6 +5,7 @@
 // LICENSE file in the root directory of this source tree.
 
 #include <array>
+#include <cstdint>
 
 // Using 32 bit integers for coordinates and memory calculations.
 
@@ -65,4 +66,30 @@ template <Int dimension> struct IntArrayHash {
   }
 };
 
+// murmur3 64 bit finaliser
+inline uint64_t fmix64(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+// Strong hash for Point<dimension>, for the sparse grids. Coordinates are
+// packed two to a 64 bit word, and each word is folded in with the murmur3
+// finaliser, so that nearby lattice points land in unrelated buckets.
+template <Int dimension> struct IntArrayMixHash {
+  std::size_t operator()(Point<dimension> const &p) const {
+    uint64_t hash = dimension;
+    for (Int i = 0; i < dimension; i += 2) {
+      uint64_t w = (uint32_t)p[i];
+      if (i + 1 < dimension)
+        w |= (uint64_t)(uint32_t)p[i + 1] << 32;
+      hash = fmix64(hash ^ w);
+    }
+    return hash;
+  }
+};
+
 #define at_kINT at::kInt
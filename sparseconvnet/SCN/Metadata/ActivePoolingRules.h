@@ -14,7 +14,7 @@
 // Remaining maxActive columns give the active sites, zero padded.
 
 template <Int dimension>
-void activePoolingRules(SparseGrids<dimension> &SGs, RuleBook &rules) {
+void activePoolingRules(SparseGrids<dimension> &SGs, TableRuleBook &rules) {
   rules.clear();
   rules.resize(2);
   auto &r = rules[0];
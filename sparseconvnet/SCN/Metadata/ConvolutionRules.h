@@ -7,32 +7,92 @@
 #ifndef CONVOLUTIONRULES_H
 #define CONVOLUTIONRULES_H
 #include "RectangularRegions.h"
+#include "SiteChunks.h"
 
+// Non-overlapping windows, size == stride, a power of two along each axis
+// (e.g. 2x2 pooling and size-2 stride-2 convolutions): input site p has the
+// single output site p >> shift, at filter offset p & mask along each axis.
+// Sets shift; false for other filters.
 template <Int dimension>
-void Convolution_InputSgToRulesAndOutputSg(SparseGrid<dimension> &inputGrid,
-                                           SparseGrid<dimension> &outputGrid,
-                                           RuleBook &rules, long *size,
-                                           long *stride, long *inputSpatialSize,
-                                           long *outputSpatialSize) {
-  rules.resize(volume<dimension>(size));
+bool Convolution_ShiftWindows(long *size, long *stride, Int *shift) {
+  for (Int i = 0; i < dimension; i++) {
+    if (size[i] != stride[i] or (size[i] & (size[i] - 1)))
+      return false;
+    for (shift[i] = 0; (1L << shift[i]) < size[i]; shift[i]++)
+      ;
+  }
+  return true;
+}
 
-  for (auto const &inIter : inputGrid.mp) {
+// With fill == false, count the rules for each filter offset (the output grid
+// is not touched). With fill == true, after rules.allocate(), create the
+// active output sites and write out the rules.
+// Only the input sites [begin, end) are visited.
+template <Int dimension>
+void Convolution_InputSgToRulesAndOutputSg(
+    SparseGrid<dimension> &inputGrid,
+    typename SparseGridMap<dimension>::iterator begin,
+    typename SparseGridMap<dimension>::iterator end,
+    SparseGrid<dimension> &outputGrid, RuleBook &rules, long *size,
+    long *stride, long *inputSpatialSize, long *outputSpatialSize, bool fill) {
+  Int shift[dimension];
+  if (Convolution_ShiftWindows<dimension>(size, stride, shift)) {
+    // The same rules, and output numbering, as the general case below
+    for (auto inIter = begin; inIter != end; ++inIter) {
+      Point<dimension> j;
+      Int rulesOffset = 0;
+      bool inside = true;
+      for (Int i = 0; i < dimension; i++) {
+        Int p = inIter->first[i];
+        j[i] = p >> shift[i];
+        inside = inside and j[i] < outputSpatialSize[i];
+        rulesOffset = (rulesOffset << shift[i]) | (p & ((1 << shift[i]) - 1));
+      }
+      if (not inside)
+        continue;
+      if (not fill) {
+        rules.count(rulesOffset);
+        continue;
+      }
+      auto outIter = outputGrid.mp.insert(std::make_pair(j, outputGrid.ctr));
+      if (outIter.second)
+        outputGrid.ctr++;
+      rules.add(rulesOffset, inIter->second + inputGrid.ctr,
+                outIter.first->second);
+    }
+    return;
+  }
+  for (auto inIter = begin; inIter != end; ++inIter) {
     auto outRegion = OutputRegionCalculator<dimension>(
-        inIter.first, size, stride, outputSpatialSize);
+        inIter->first, size, stride, outputSpatialSize);
     for (auto j : outRegion) {
       auto inRegion = InputRegionCalculator<dimension>(j, size, stride);
-      Int rulesOffset = inRegion.offset(inIter.first);
+      Int rulesOffset = inRegion.offset(inIter->first);
+      if (not fill) {
+        rules.count(rulesOffset);
+        continue;
+      }
       auto outIter = outputGrid.mp.find(j);
       if (outIter == outputGrid.mp.end()) {
         outIter =
             outputGrid.mp.insert(std::make_pair(j, outputGrid.ctr++)).first;
       }
-      rules[rulesOffset].push_back(inIter.second + inputGrid.ctr);
-      rules[rulesOffset].push_back(outIter->second);
+      rules.add(rulesOffset, inIter->second + inputGrid.ctr, outIter->second);
     }
   }
 }
 
+template <Int dimension>
+void Convolution_InputSgToRulesAndOutputSg(SparseGrid<dimension> &inputGrid,
+                                           SparseGrid<dimension> &outputGrid,
+                                           RuleBook &rules, long *size,
+                                           long *stride, long *inputSpatialSize,
+                                           long *outputSpatialSize, bool fill) {
+  Convolution_InputSgToRulesAndOutputSg<dimension>(
+      inputGrid, inputGrid.mp.begin(), inputGrid.mp.end(), outputGrid, rules,
+      size, stride, inputSpatialSize, outputSpatialSize, fill);
+}
+
 template <Int dimension>
 Int Convolution_InputSgsToRulesAndOutputSgs(SparseGrids<dimension> &input_SGs,
                                             SparseGrids<dimension> &output_SGs,
@@ -40,10 +100,15 @@ Int Convolution_InputSgsToRulesAndOutputSgs(SparseGrids<dimension> &input_SGs,
                                             long *filterStride,
                                             long *input_spatialSize,
                                             long *output_spatialSize) {
-  rules.clear();
   output_SGs.clear();
   Int batchSize = input_SGs.size();
   output_SGs.resize(batchSize);
+  rules.startCounting(volume<dimension>(filterSize));
+  for (Int i = 0; i < batchSize; i++)
+    Convolution_InputSgToRulesAndOutputSg<dimension>(
+        input_SGs[i], output_SGs[i], rules, filterSize, filterStride,
+        input_spatialSize, output_spatialSize, false);
+  rules.allocate();
   Int output_nActive = 0;
   for (Int i = 0; i < batchSize; i++) {
     auto &iSG = input_SGs[i];
@@ -51,7 +116,7 @@ Int Convolution_InputSgsToRulesAndOutputSgs(SparseGrids<dimension> &input_SGs,
     oSG.ctr = output_nActive;
     Convolution_InputSgToRulesAndOutputSg<dimension>(
         iSG, oSG, rules, filterSize, filterStride, input_spatialSize,
-        output_spatialSize);
+        output_spatialSize, true);
     output_nActive = oSG.ctr;
     oSG.ctr = 0;
   }
@@ -63,19 +128,62 @@ Int Convolution_InputSgsToRulesAndOutputSgs_OMP(
     SparseGrids<dimension> &input_SGs, SparseGrids<dimension> &output_SGs,
     RuleBook &rules, long *filterSize, long *filterStride,
     long *input_spatialSize, long *output_spatialSize) {
-  rules.clear();
-  rules.resize(volume<dimension>(filterSize));
+  Int sd = volume<dimension>(filterSize);
   output_SGs.clear();
   Int batchSize = input_SGs.size();
   output_SGs.resize(batchSize);
-  std::vector<RuleBook> rbs(batchSize);
+  // Each chunk of input sites numbers the output sites it reaches in a grid
+  // of its own; outputRows[j] then maps chunk j's numbering to its sample's.
+  auto chunks = SiteChunks<dimension>(input_SGs);
+  Int nChunks = chunks.size();
+  std::vector<RuleBook> rbs(nChunks);
+  std::vector<SparseGrid<dimension>> chunkSGs(nChunks);
+  for (auto &cSG : chunkSGs)
+    cSG.mp.setSpatialSize(output_SGs.spatialSize);
+  std::vector<std::vector<Int>> outputRows(nChunks);
   {
     Int i;
-#pragma omp parallel for private(i)
-    for (i = 0; i < batchSize; i++)
+#pragma omp parallel for schedule(dynamic) private(i)
+    for (i = 0; i < nChunks; i++) {
+      auto &c = chunks[i];
+      rbs[i].startCounting(sd);
+      Convolution_InputSgToRulesAndOutputSg<dimension>(
+          input_SGs[c.sample], c.begin, c.end, chunkSGs[i], rbs[i], filterSize,
+          filterStride, input_spatialSize, output_spatialSize, false);
+      rbs[i].allocate();
       Convolution_InputSgToRulesAndOutputSg<dimension>(
-          input_SGs[i], output_SGs[i], rbs[i], filterSize, filterStride,
-          input_spatialSize, output_spatialSize);
+          input_SGs[c.sample], c.begin, c.end, chunkSGs[i], rbs[i], filterSize,
+          filterStride, input_spatialSize, output_spatialSize, true);
+    }
+  }
+  // Merge the chunks' output sites into the samples' grids, chunk by chunk and
+  // in the order the chunks found them, which gives the numbering of the
+  // serial generator. Different samples are merged in parallel.
+  std::vector<Int> firstChunk(batchSize + 1, nChunks);
+  for (Int j = nChunks - 1; j >= 0; j--)
+    firstChunk[chunks[j].sample] = j;
+  for (Int i = batchSize - 1; i >= 0; i--)
+    firstChunk[i] = std::min(firstChunk[i], firstChunk[i + 1]);
+  {
+    Int i;
+#pragma omp parallel for schedule(dynamic) private(i)
+    for (i = 0; i < batchSize; i++) {
+      auto &oSG = output_SGs[i];
+      for (Int j = firstChunk[i]; j < firstChunk[i + 1]; j++) {
+        auto &cSG = chunkSGs[j];
+        std::vector<Point<dimension>> points(cSG.ctr);
+        for (auto const &iter : cSG.mp)
+          points[iter.second] = iter.first;
+        outputRows[j].resize(cSG.ctr);
+        for (Int k = 0; k < cSG.ctr; k++) {
+          auto iter = oSG.mp.insert(std::make_pair(points[k], oSG.ctr));
+          if (iter.second)
+            oSG.ctr++;
+          outputRows[j][k] = iter.first->second;
+        }
+        cSG.mp = SparseGridMap<dimension>();
+      }
+    }
   }
   Int output_nActive = 0;
   for (Int i = 0; i < batchSize; i++) {
@@ -86,21 +194,12 @@ Int Convolution_InputSgsToRulesAndOutputSgs_OMP(
     output_nActive += output_SGs[i].ctr;
     output_SGs[i].ctr = tmp;
   }
-  {
-    Int i;
-#pragma omp parallel for private(i)
-    for (i = 0; i < (Int)rules.size(); i++) {
-      auto &R = rules[i];
-      for (Int j = 0; j < batchSize; j++) {
-        auto &r = rbs[j][i];
-        auto offset = output_SGs[j].ctr;
-        for (Int k = 0; k < (Int)r.size();) {
-          R.push_back(r[k++]);
-          R.push_back(r[k++] + offset);
-        }
-      }
-    }
-  }
+  rules.concatenate(rbs, sd,
+                    [&](Int j, Int r) {
+                      return outputRows[j][r] +
+                             output_SGs[chunks[j].sample].ctr;
+                    },
+                    true);
   return output_nActive;
 }
 
@@ -110,8 +209,10 @@ template <Int dimension>
 void SparseToDense_InputSgsToRulesAndOutputSgs(
     SparseGrids<dimension> &input_SGs, RuleBook &rules, long *spatialSize) {
   Int batchSize = input_SGs.size();
-  rules.clear();
-  rules.resize(batchSize);
+  rules.startCounting(batchSize);
+  for (Int batchIdx = 0; batchIdx < batchSize; batchIdx++)
+    rules.count(batchIdx, input_SGs[batchIdx].mp.size());
+  rules.allocate();
   Point<dimension> lb, ub;
   for (Int i = 0; i < dimension; ++i) {
     lb[i] = 0;
@@ -120,10 +221,9 @@ void SparseToDense_InputSgsToRulesAndOutputSgs(
   auto region = RectangularRegion<dimension>(lb, ub);
   for (Int batchIdx = 0; batchIdx < batchSize; batchIdx++) {
     auto &iSG = input_SGs[batchIdx];
-    for (auto const &inIter : iSG.mp) {
-      rules[batchIdx].push_back(inIter.second + iSG.ctr);
-      rules[batchIdx].push_back(region.offset(inIter.first));
-    }
+    for (auto const &inIter : iSG.mp)
+      rules.add(batchIdx, inIter.second + iSG.ctr,
+                region.offset(inIter.first));
   }
 }
 
@@ -131,8 +231,10 @@ template <Int dimension>
 void SparseToDense_InputSgsToRulesAndOutputSgs_OMP(
     SparseGrids<dimension> &input_SGs, RuleBook &rules, long *spatialSize) {
   Int batchSize = input_SGs.size();
-  rules.clear();
-  rules.resize(batchSize);
+  rules.startCounting(batchSize);
+  for (Int batchIdx = 0; batchIdx < batchSize; batchIdx++)
+    rules.count(batchIdx, input_SGs[batchIdx].mp.size());
+  rules.allocate();
   Point<dimension> lb, ub;
   for (Int i = 0; i < dimension; ++i) {
     lb[i] = 0;
@@ -143,9 +245,10 @@ void SparseToDense_InputSgsToRulesAndOutputSgs_OMP(
 #pragma omp parallel for private(batchIdx)
   for (batchIdx = 0; batchIdx < batchSize; batchIdx++) {
     auto &iSG = input_SGs[batchIdx];
+    Int *r = rules[batchIdx];
     for (auto const &inIter : iSG.mp) {
-      rules[batchIdx].push_back(inIter.second + iSG.ctr);
-      rules[batchIdx].push_back(region.offset(inIter.first));
+      *r++ = inIter.second + iSG.ctr;
+      *r++ = region.offset(inIter.first);
     }
   }
 }
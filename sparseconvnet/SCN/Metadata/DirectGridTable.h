@@ -0,0 +1,101 @@
+// Copyright 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef DIRECTGRIDTABLE_H
+#define DIRECTGRIDTABLE_H
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Direct-addressed table from the points of a small box [0, box) to row
+// numbers, for grids with at most directGridMaxVolume points, at least
+// 1 / directGridMinDensity of them active (see SparseGridMap::setSpatialSize):
+// a lookup is a single array access, with no hashing. As in PackedHashTable,
+// entries are addressed by slot; slots are numbered in the order the points
+// were inserted, and size() is the "end" slot.
+const long directGridMaxVolume = 1 << 16;
+const long directGridMinDensity = 256;
+
+template <Int dimension> class DirectGridTable {
+public:
+  Point<dimension> box;
+  // Slot of each point of the box, or -1
+  std::vector<Int> slots;
+  // Index in the box, and row, of the point in each slot
+  std::vector<Int> cells, values;
+
+  DirectGridTable() { box.fill(0); }
+  // Number of points in the box [0, b), or 0 if that is too many
+  static long volume(const Point<dimension> &b) {
+    long v = 1;
+    for (Int i = 0; i < dimension; i++) {
+      if (b[i] <= 0 or b[i] > directGridMaxVolume)
+        return 0;
+      v *= b[i];
+      if (v > directGridMaxVolume)
+        return 0;
+    }
+    return v;
+  }
+  // Empty the table, and make it cover [0, b)
+  void reset(const Point<dimension> &b) {
+    box = b;
+    slots.assign(volume(b), -1);
+    cells.clear();
+    values.clear();
+  }
+  std::size_t size() const { return cells.size(); }
+  bool inside(const Point<dimension> &p) const {
+    for (Int i = 0; i < dimension; i++)
+      if (p[i] < 0 or p[i] >= box[i])
+        return false;
+    return true;
+  }
+  Int index(const Point<dimension> &p) const {
+    Int k = 0;
+    for (Int i = 0; i < dimension; i++)
+      k = k * box[i] + p[i];
+    return k;
+  }
+  Point<dimension> point(Int k) const {
+    Point<dimension> p;
+    for (Int i = dimension - 1; i >= 0; i--) {
+      p[i] = k % box[i];
+      k /= box[i];
+    }
+    return p;
+  }
+  // Slot holding p, or size()
+  std::size_t find(const Point<dimension> &p) const {
+    if (not inside(p))
+      return size();
+    Int s = slots[index(p)];
+    return s < 0 ? size() : s;
+  }
+  // Row of p, or -1
+  Int row(const Point<dimension> &p) const {
+    if (not inside(p))
+      return -1;
+    Int s = slots[index(p)];
+    return s < 0 ? -1 : values[s];
+  }
+  // Slot holding p, which must be inside the box, inserting (p, v) first if p
+  // is absent
+  std::pair<std::size_t, bool> insert(const Point<dimension> &p, Int v) {
+    Int k = index(p);
+    if (slots[k] >= 0)
+      return std::make_pair((std::size_t)slots[k], false);
+    slots[k] = cells.size();
+    cells.push_back(k);
+    values.push_back(v);
+    return std::make_pair((std::size_t)slots[k], true);
+  }
+  void reserve(std::size_t n) {
+    cells.reserve(n);
+    values.reserve(n);
+  }
+};
+#endif /* DIRECTGRIDTABLE_H */
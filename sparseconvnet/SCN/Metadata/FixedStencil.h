@@ -0,0 +1,150 @@
+// Copyright 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef FIXEDSTENCIL_H
+#define FIXEDSTENCIL_H
+#include "SparseGridMap.h"
+#include <type_traits>
+
+// Compile-time submanifold stencils for the common filters: size 2, 3 or 5
+// along every axis, in 2 or 3 dimensions, up to fixedStencilMaxVolume offsets.
+// The offsets, and the increments of packed keys that they make, are
+// constexpr, and the batched neighbour lookups are unrolled, so each lookup
+// adds a constant to the packed key of the site. Other filters use
+// SparseGridStencil, which holds the same offsets in the same order (that of
+// InputRegionCalculator_Valid). Unrolling 5x5x5 lookups makes them slower.
+const Int fixedStencilMaxVolume = 32;
+
+constexpr Int FixedStencil_power(Int base, Int exponent) {
+  return exponent == 0 ? 1 : base * FixedStencil_power(base, exponent - 1);
+}
+
+template <Int dimension, Int size> class FixedStencil {
+public:
+  static constexpr Int volume = FixedStencil_power(size, dimension);
+  static constexpr Int lo = -(size / 2);
+  static constexpr Int hi = size - 1 - size / 2;
+  // Component i of offset k; the last axis varies fastest
+  static constexpr Int offset(Int k, Int i) {
+    return k / FixedStencil_power(size, dimension - 1 - i) % size + lo;
+  }
+  // Offset k as an increment of packed keys
+  static constexpr uint64_t delta(Int k, Int i = 0) {
+    return i == dimension
+               ? 0
+               : ((uint64_t)(int64_t)offset(k, i)
+                  << (i * SparseGridMap<dimension>::packedBits)) +
+                     delta(k, i + 1);
+  }
+  // Whether p and its neighbours all pack
+  static bool inside(const Point<dimension> &p) {
+    for (Int i = 0; i < dimension; i++)
+      if (p[i] + lo < 0 or ((uint64_t)(p[i] + hi) >>
+                            SparseGridMap<dimension>::packedBits))
+        return false;
+    return true;
+  }
+};
+
+// Unrolled lookups of the offsets k, K <= k < N
+template <Int dimension, Int size, Int K, Int N> class FixedStencilFind {
+public:
+  using Delta = std::integral_constant<
+      uint64_t, FixedStencil<dimension, size>::delta(K)>;
+  static void prefetch(const PackedHashTable &t, uint64_t base) {
+#if defined(__GNUC__)
+    __builtin_prefetch(&t.keys[t.bucket(base + Delta::value)]);
+#endif
+    FixedStencilFind<dimension, size, K + 1, N>::prefetch(t, base);
+  }
+  static void find(const PackedHashTable &t, uint64_t base, Int *rows) {
+    std::size_t i = t.find(base + Delta::value);
+    rows[K] = i < t.capacity() ? t.values[i] : -1;
+    FixedStencilFind<dimension, size, K + 1, N>::find(t, base, rows);
+  }
+};
+template <Int dimension, Int size, Int N>
+class FixedStencilFind<dimension, size, N, N> {
+public:
+  static void prefetch(const PackedHashTable &, uint64_t) {}
+  static void find(const PackedHashTable &, uint64_t, Int *) {}
+};
+
+// Neighbour lookups for the rule generators: rows[k] = row of the active site
+// p + offset k, or -1, for the offsets of stencil. StencilLookup works for any
+// stencil; FixedStencilLookup for the first N offsets of a FixedStencil,
+// stencil holding the same offsets for the sites it cannot pack.
+template <Int dimension> class StencilLookup {
+public:
+  Int size(const SparseGridStencil<dimension> &stencil) const {
+    return stencil.size();
+  }
+  void operator()(const SparseGridMap<dimension> &mp,
+                  const Point<dimension> &p,
+                  const SparseGridStencil<dimension> &stencil,
+                  Int *rows) const {
+    mp.findNeighbours(p, stencil, rows);
+  }
+};
+template <Int dimension, Int size_, Int N> class FixedStencilLookup {
+public:
+  Int size(const SparseGridStencil<dimension> &) const { return N; }
+  void operator()(const SparseGridMap<dimension> &mp,
+                  const Point<dimension> &p,
+                  const SparseGridStencil<dimension> &stencil,
+                  Int *rows) const {
+    if (mp.packed and FixedStencil<dimension, size_>::inside(p)) {
+      uint64_t base = SparseGridMap<dimension>::pack(p);
+      FixedStencilFind<dimension, size_, 0, N>::prefetch(mp.packedMap, base);
+      FixedStencilFind<dimension, size_, 0, N>::find(mp.packedMap, base, rows);
+    } else {
+      mp.findNeighbours(p, stencil, rows);
+    }
+  }
+};
+
+// If size is s = 2, 3 or 5 along every axis, dimension is 2 or 3, and
+// FixedStencil<dimension, s> is not too large, calls f.template run<s>() and
+// returns true; otherwise false.
+template <Int dimension> class FixedStencils {
+public:
+  template <typename F> static bool dispatch(long *, F &) { return false; }
+};
+template <Int dimension> class FixedStencils_Cubes {
+public:
+  template <typename F> static bool dispatch(long *size, F &f) {
+    for (Int i = 1; i < dimension; i++)
+      if (size[i] != size[0])
+        return false;
+    switch (size[0]) {
+    case 2:
+      return run<2>(f);
+    case 3:
+      return run<3>(f);
+    case 5:
+      return run<5>(f);
+    }
+    return false;
+  }
+
+private:
+  template <Int size, typename F> static bool run(F &f) {
+    return run<size>(f, std::integral_constant<
+                            bool, FixedStencil<dimension, size>::volume <=
+                                      fixedStencilMaxVolume>());
+  }
+  template <Int size, typename F> static bool run(F &f, std::true_type) {
+    f.template run<size>();
+    return true;
+  }
+  template <Int size, typename F> static bool run(F &, std::false_type) {
+    return false;
+  }
+};
+template <> class FixedStencils<2> : public FixedStencils_Cubes<2> {};
+template <> class FixedStencils<3> : public FixedStencils_Cubes<3> {};
+
+#endif /* FIXEDSTENCIL_H */
@@ -8,26 +8,28 @@
 #define FULLDECONVOLUTIONRULES_H
 #include "RectangularRegions.h"
 
+// Two passes, as for Convolution_InputSgToRulesAndOutputSg
 template <Int dimension>
 void FullConvolution_InputSgToRulesAndOutputSg(
     SparseGrid<dimension> &inputGrid, SparseGrid<dimension> &outputGrid,
     RuleBook &rules, long *size, long *stride, long *inputSpatialSize,
-    long *outputSpatialSize) {
-  rules.resize(volume<dimension>(size));
-
+    long *outputSpatialSize, bool fill) {
   // Swap Input.. and OutputRegionCalculator v.s. a normal Convolution
   for (auto const &inIter : inputGrid.mp) {
     auto outRegion =
         InputRegionCalculator<dimension>(inIter.first, size, stride);
     for (auto j : outRegion) {
       Int rulesOffset = outRegion.offset(j);
+      if (not fill) {
+        rules.count(rulesOffset);
+        continue;
+      }
       auto outIter = outputGrid.mp.find(j);
       if (outIter == outputGrid.mp.end()) {
         outIter =
             outputGrid.mp.insert(std::make_pair(j, outputGrid.ctr++)).first;
       }
-      rules[rulesOffset].push_back(inIter.second + inputGrid.ctr);
-      rules[rulesOffset].push_back(outIter->second);
+      rules.add(rulesOffset, inIter.second + inputGrid.ctr, outIter->second);
     }
   }
 }
@@ -37,10 +39,15 @@ Int FullConvolution_InputSgsToRulesAndOutputSgs(
     SparseGrids<dimension> &input_SGs, SparseGrids<dimension> &output_SGs,
     RuleBook &rules, long *filterSize, long *filterStride,
     long *input_spatialSize, long *output_spatialSize) {
-  rules.clear();
   output_SGs.clear();
   Int batchSize = input_SGs.size();
   output_SGs.resize(batchSize);
+  rules.startCounting(volume<dimension>(filterSize));
+  for (Int i = 0; i < batchSize; i++)
+    FullConvolution_InputSgToRulesAndOutputSg<dimension>(
+        input_SGs[i], output_SGs[i], rules, filterSize, filterStride,
+        input_spatialSize, output_spatialSize, false);
+  rules.allocate();
   Int output_nActive = 0;
   for (Int i = 0; i < batchSize; i++) {
     auto &iSG = input_SGs[i];
@@ -48,7 +55,7 @@ Int FullConvolution_InputSgsToRulesAndOutputSgs(
     oSG.ctr = output_nActive;
     FullConvolution_InputSgToRulesAndOutputSg<dimension>(
         iSG, oSG, rules, filterSize, filterStride, input_spatialSize,
-        output_spatialSize);
+        output_spatialSize, true);
     output_nActive = oSG.ctr;
     oSG.ctr = 0;
   }
@@ -60,8 +67,7 @@ Int FullConvolution_InputSgsToRulesAndOutputSgs_OMP(
     SparseGrids<dimension> &input_SGs, SparseGrids<dimension> &output_SGs,
     RuleBook &rules, long *filterSize, long *filterStride,
     long *input_spatialSize, long *output_spatialSize) {
-  rules.clear();
-  rules.resize(volume<dimension>(filterSize));
+  Int sd = volume<dimension>(filterSize);
   output_SGs.clear();
   Int batchSize = input_SGs.size();
   output_SGs.resize(batchSize);
@@ -69,10 +75,16 @@ Int FullConvolution_InputSgsToRulesAndOutputSgs_OMP(
   {
     Int i;
 #pragma omp parallel for private(i)
-    for (i = 0; i < batchSize; i++)
+    for (i = 0; i < batchSize; i++) {
+      rbs[i].startCounting(sd);
       FullConvolution_InputSgToRulesAndOutputSg<dimension>(
           input_SGs[i], output_SGs[i], rbs[i], filterSize, filterStride,
-          input_spatialSize, output_spatialSize);
+          input_spatialSize, output_spatialSize, false);
+      rbs[i].allocate();
+      FullConvolution_InputSgToRulesAndOutputSg<dimension>(
+          input_SGs[i], output_SGs[i], rbs[i], filterSize, filterStride,
+          input_spatialSize, output_spatialSize, true);
+    }
   }
   Int output_nActive = 0;
   for (Int i = 0; i < batchSize; i++) {
@@ -83,21 +95,8 @@ Int FullConvolution_InputSgsToRulesAndOutputSgs_OMP(
     output_nActive += output_SGs[i].ctr;
     output_SGs[i].ctr = tmp;
   }
-  {
-    Int i;
-#pragma omp parallel for private(i)
-    for (i = 0; i < (Int)rules.size(); i++) {
-      auto &R = rules[i];
-      for (Int j = 0; j < batchSize; j++) {
-        auto &r = rbs[j][i];
-        auto offset = output_SGs[j].ctr;
-        for (Int k = 0; k < (Int)r.size();) {
-          R.push_back(r[k++]);
-          R.push_back(r[k++] + offset);
-        }
-      }
-    }
-  }
+  rules.concatenate(
+      rbs, sd, [&](Int j, Int r) { return r + output_SGs[j].ctr; }, true);
   return output_nActive;
 }
 #endif /* FULLDECONVOLUTIONRULES_H */
@@ -17,9 +17,9 @@
 
 // mode 0==guaranteed unique 1==overwrite, 2=keep, 3=sum, 4=mean
 template <Int dimension>
-void inputLayerRules(SparseGrids<dimension> &SGs, RuleBook &rules, long *coords,
-                     Int nInputRows, Int nInputColumns, Int batchSize, Int mode,
-                     Int &nActive) {
+void inputLayerRules(SparseGrids<dimension> &SGs, TableRuleBook &rules,
+                     long *coords, Int nInputRows, Int nInputColumns,
+                     Int batchSize, Int mode, Int &nActive) {
   assert(nActive == 0);
   assert(rules.size() == 0);
   assert(SGs.size() == 0);
@@ -137,7 +137,7 @@ void inputLayerRules(SparseGrids<dimension> &SGs, RuleBook &rules, long *coords,
 // mode 0==guaranteed unique and all present; 1==overwrite, 2=keep, 3=sum,
 // 4=mean
 template <Int dimension>
-void blRules(SparseGrids<dimension> &SGs, RuleBook &rules, long *coords,
+void blRules(SparseGrids<dimension> &SGs, TableRuleBook &rules, long *coords,
              Int batchSize, Int length, Int mode, Int &nActive) {
   assert(nActive == 0);
   assert(rules.size() == 0);
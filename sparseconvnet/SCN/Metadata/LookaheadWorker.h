@@ -0,0 +1,76 @@
+// Copyright 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef LOOKAHEADWORKER_H
+#define LOOKAHEADWORKER_H
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// A background thread that builds a list of rulebook requests in order, while
+// the layers that come first run (see Metadata::startLookahead). Each cache
+// entry that a request writes is indexed by its address; wait(entry) blocks
+// until the request that writes entry is done, and returns at once for
+// entries that the thread does not touch. Grids are also indexed by the last
+// request that reads or writes them, for waitForUses. The indices are kept
+// until the next start, so that wait and join can be called from several
+// threads.
+class LookaheadWorker {
+public:
+  std::thread worker;
+  std::mutex mutex, joinMutex;
+  std::condition_variable cv;
+  // Count of requests built so far
+  Int done;
+  std::unordered_map<const void *, Int> index, lastUse;
+  LookaheadWorker() : done(0) {}
+  // Copies do not share the thread
+  LookaheadWorker(const LookaheadWorker &) : done(0) {}
+  LookaheadWorker &operator=(const LookaheadWorker &) {
+    join();
+    return *this;
+  }
+  ~LookaheadWorker() { join(); }
+  // Call while not running, with the index filled in; build(j) builds request
+  // j.
+  void start(Int nRequests, std::function<void(Int)> build) {
+    done = 0;
+    worker = std::thread([this, nRequests, build]() {
+      for (Int j = 0; j < nRequests; j++) {
+        build(j);
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          done = j + 1;
+        }
+        cv.notify_all();
+      }
+    });
+  }
+  void wait(const void *entry) { waitFor(index, entry); }
+  // Block until no request left reads or writes grid
+  void waitForUses(const void *grid) { waitFor(lastUse, grid); }
+  // Wait for all the requests
+  void join() {
+    std::lock_guard<std::mutex> lock(joinMutex);
+    if (worker.joinable())
+      worker.join();
+  }
+
+private:
+  void waitFor(const std::unordered_map<const void *, Int> &requests,
+               const void *key) {
+    auto it = requests.find(key);
+    if (it == requests.end())
+      return;
+    Int j = it->second;
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return done > j; });
+  }
+};
+
+#endif /* LOOKAHEADWORKER_H */
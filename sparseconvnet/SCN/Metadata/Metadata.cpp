@@ -10,17 +10,13 @@
 #include "ConvolutionRules.h"
 #include "FullConvolutionRules.h"
 #include "IOLayersRules.h"
+#include "MetadataFile.h"
+#include "MortonOrder.h"
 #include "RandomizedStrideRules.h"
 #include "SubmanifoldConvolutionRules.h"
+#include "SortedRules.h"
 
-template <Int dimension> SparseGrid<dimension>::SparseGrid() : ctr(0) {
-  // Sparsehash needs a key to be set aside and never used - we use
-  // (-1,...,-1)
-  Point<dimension> empty_key;
-  for (Int i = 0; i < dimension; ++i)
-    empty_key[i] = -1;
-  mp.set_empty_key(empty_key);
-}
+template <Int dimension> SparseGrid<dimension>::SparseGrid() : ctr(0) {}
 
 template <typename T> T *OptionalTensorData(at::Tensor tensor) {
   return tensor.numel() ? tensor.data<T>() : nullptr;
@@ -46,40 +42,67 @@ void addPointToSparseGridMapAndFeatures(SparseGridMap<dimension> &mp,
 
 template <Int dimension>
 Metadata<dimension>::Metadata()
-    : re(std::chrono::system_clock::now().time_since_epoch().count()) {}
+    : re(std::chrono::system_clock::now().time_since_epoch().count()),
+      sortedRuleBooks(false), mortonOrdered(false), inputHashKnown(false),
+      recording(false) {}
 
 template <Int dimension> void Metadata<dimension>::clear() {
+  finishLookahead();
   nActive.clear();
   grids.clear();
   activePoolingRuleBooks.clear();
   inputLayerRuleBook.clear();
   validRuleBooks.clear();
+  neighbourTables.clear();
   ruleBooks.clear();
   fullConvolutionRuleBooks.clear();
   sparseToDenseRuleBooks.clear();
+  spatialLocations.clear();
+  inputHashKnown = false;
   inputSGs = nullptr;
   inputSG = nullptr;
   inputNActive = nullptr;
   inputLayerRuleBook.clear();
   blLayerRuleBook.clear();
+  recordedPlan.clear();
+  recorded.clear();
+}
+template <Int dimension>
+void Metadata<dimension>::setSortedRuleBooks(bool sorted) {
+  sortedRuleBooks = sorted;
+  inputHashKnown = false;
 }
 template <Int dimension>
 Int Metadata<dimension>::getNActive(/*long*/ at::Tensor spatialSize) {
-  return nActive[LongTensorToPoint<dimension>(spatialSize)];
+  std::unique_lock<std::mutex> lock(cacheGuard.mutex);
+  auto &n = nActive[LongTensorToPoint<dimension>(spatialSize)];
+  cacheGuard.wait(lock, &n);
+  lock.unlock();
+  lookahead.wait(&n);
+  return n;
 };
 template <Int dimension>
 SparseGrids<dimension> &
 Metadata<dimension>::getSparseGrid(/*long*/ at::Tensor spatialSize) {
-  return grids[LongTensorToPoint<dimension>(spatialSize)];
+  std::unique_lock<std::mutex> lock(cacheGuard.mutex);
+  auto &SGs = grids[LongTensorToPoint<dimension>(spatialSize)];
+  cacheGuard.wait(lock, &SGs);
+  lock.unlock();
+  lookahead.wait(&SGs);
+  return SGs;
 };
 template <Int dimension>
 void Metadata<dimension>::setInputSpatialSize(/*long*/ at::Tensor spatialSize) {
+  finishLookahead();
   inputSpatialSize = LongTensorToPoint<dimension>(spatialSize);
+  inputHashKnown = false;
   inputSGs = &grids[inputSpatialSize];
   inputNActive = &nActive[inputSpatialSize];
 }
 template <Int dimension> void Metadata<dimension>::batchAddSample() {
   assert(inputSGs && "Call setInputSpatialSize first, please!");
+  finishLookahead();
+  inputHashKnown = false;
   inputSGs->resize(inputSGs->size() + 1);
   inputSG = &inputSGs->back();
 }
@@ -88,6 +111,8 @@ void Metadata<dimension>::setInputSpatialLocation(/*float*/ at::Tensor features,
                                                   /*long*/ at::Tensor location,
                                                   /*float*/ at::Tensor vec,
                                                   bool overwrite) {
+  finishLookahead();
+  inputHashKnown = false;
   auto p = LongTensorToPoint<dimension>(location);
   SparseGridMap<dimension> &mp = inputSG->mp;
   Int &nActive = *inputNActive;
@@ -100,6 +125,8 @@ void Metadata<dimension>::setInputSpatialLocations(
     /*float*/ at::Tensor features,
     /*long*/ at::Tensor locations,
     /*float*/ at::Tensor vecs, bool overwrite) {
+  finishLookahead();
+  inputHashKnown = false;
   /* assert(locations.ndimension() == 2 and "locations must be 2
    * dimensional!"); */
   /* assert(vecs.ndimension() == 2 and "vecs must be 2 dimensional!"); */
@@ -108,64 +135,389 @@ void Metadata<dimension>::setInputSpatialLocations(
   /* assert((locations.size(1) == dimension or */
   /*         locations.size(1) == 1 + dimension) and */
   /*        "locations.size(0) must be either dimension or dimension+1"); */
-  Point<dimension> p;
   Int &nActive = *inputNActive;
   auto nPlanes = vecs.size(1);
   long *l = locations.data<long>();
   float *v = vecs.data<float>();
+  Int nRows = locations.size(0), nColumns = locations.size(1);
+  if (nColumns != dimension and nColumns != dimension + 1)
+    return;
 
-  if (locations.size(1) == dimension) {
+  // The grid each row goes to: the current sample, or the sample given by the
+  // last column (adding new samples to the batch as necessary)
+  std::vector<SparseGrid<dimension> *> grid;
+  std::vector<Int> rowGrid(nRows, 0);
+  if (nColumns == dimension) {
     // add points to current sample
     assert(inputSG);
-    SparseGridMap<dimension> &mp = inputSG->mp;
-    for (Int idx = 0; idx < locations.size(0); ++idx) {
+    grid.push_back(inputSG);
+  } else {
+    auto &SGs = *inputSGs;
+    for (Int idx = 0; idx < nRows; ++idx)
+      if (l[idx * nColumns + dimension] >= (long)SGs.size())
+        SGs.resize(l[idx * nColumns + dimension] + 1);
+    for (auto &sg : SGs)
+      grid.push_back(&sg);
+    for (Int idx = 0; idx < nRows; ++idx)
+      rowGrid[idx] = l[idx * nColumns + dimension];
+  }
+  // rows[rowStart[g] ... rowStart[g + 1] - 1]: the rows for grid g, in order
+  Int nGrids = grid.size();
+  std::vector<Int> rowStart(nGrids + 1, 0), rows(nRows);
+  for (Int idx = 0; idx < nRows; ++idx)
+    rowStart[rowGrid[idx] + 1]++;
+  std::partial_sum(rowStart.begin(), rowStart.end(), rowStart.begin());
+  {
+    std::vector<Int> cursor(rowStart.begin(), rowStart.end() - 1);
+    for (Int idx = 0; idx < nRows; ++idx)
+      rows[cursor[rowGrid[idx]]++] = idx;
+  }
+
+  // For each row, the feature row it goes to; while the active sites that are
+  // new are being counted, -1 - (the first row with the same location)
+  std::vector<Int> target(nRows);
+  std::vector<char> first(nRows, 0);
+  Int g;
+#pragma omp parallel for schedule(dynamic) private(g)
+  for (g = 0; g < nGrids; g++) {
+    auto &mp = grid[g]->mp;
+    mp.reserve(mp.size() + rowStart[g + 1] - rowStart[g]);
+    for (Int j = rowStart[g]; j < rowStart[g + 1]; j++) {
+      Int idx = rows[j];
+      Point<dimension> p;
       for (Int d = 0; d < dimension; ++d)
-        p[d] = *l++;
-      addPointToSparseGridMapAndFeatures<dimension>(mp, p, nActive, nPlanes,
-                                                    features, v, overwrite);
-      v += nPlanes;
+        p[d] = l[idx * nColumns + d];
+      auto iter = mp.insert(std::make_pair(p, -1 - idx));
+      first[idx] = iter.second;
+      target[idx] = iter.first->second;
     }
   }
-  if (locations.size(1) == dimension + 1) {
-    // add new samples to batch as necessary
-    auto &SGs = *inputSGs;
-    for (Int idx = 0; idx < locations.size(0); ++idx) {
-      for (Int d = 0; d < dimension; ++d)
-        p[d] = *l++;
-      Int batch = *l++;
-      if (batch >= (Int)SGs.size()) {
-        SGs.resize(batch + 1);
+  // New active sites are numbered in the order of their first rows
+  Int oldNActive = nActive;
+  for (Int idx = 0; idx < nRows; ++idx)
+    if (first[idx])
+      target[idx] = nActive++;
+  if (nActive > oldNActive)
+    features.resize_({(int)nActive, nPlanes});
+  float *f = features.data<float>();
+#pragma omp parallel for schedule(dynamic) private(g)
+  for (g = 0; g < nGrids; g++) {
+    auto &mp = grid[g]->mp;
+    for (Int j = rowStart[g]; j < rowStart[g + 1]; j++) {
+      Int idx = rows[j];
+      if (first[idx]) {
+        Point<dimension> p;
+        for (Int d = 0; d < dimension; ++d)
+          p[d] = l[idx * nColumns + d];
+        mp[p] = target[idx];
+      } else if (target[idx] < 0) {
+        target[idx] = target[-1 - target[idx]];
       }
-      SparseGridMap<dimension> &mp = SGs[batch].mp;
-      addPointToSparseGridMapAndFeatures<dimension>(mp, p, nActive, nPlanes,
-                                                    features, v, overwrite);
-      v += nPlanes;
+      // Later rows overwrite earlier ones with overwrite == true
+      if (first[idx] or overwrite)
+        std::memcpy(f + (long)target[idx] * nPlanes, v + (long)idx * nPlanes,
+                    sizeof(float) * nPlanes);
     }
   }
 }
+template <Int dimension>
+void Metadata<dimension>::mortonOrderInput(/*float*/ at::Tensor features) {
+  assert(inputSGs && "Call setInputSpatialSize first, please!");
+  finishLookahead();
+  mortonOrdered = true;
+  inputHashKnown = false;
+  // Rulebooks built so far refer to the old numbering
+  activePoolingRuleBooks.clear();
+  validRuleBooks.clear();
+  neighbourTables.clear();
+  ruleBooks.clear();
+  fullConvolutionRuleBooks.clear();
+  sparseToDenseRuleBooks.clear();
+  inputLayerRuleBook.clear();
+  blLayerRuleBook.clear();
+  spatialLocations.clear();
+  recorded.clear();
+  Int nActive = *inputNActive;
+  std::vector<Int> newRow;
+  MortonOrder_renumber<dimension>(*inputSGs, newRow, nActive);
+  if (features.numel() == 0)
+    return;
+  assert(features.size(0) == nActive && "features must have nActive rows");
+  auto nPlanes = features.size(1);
+  float *f = features.data<float>();
+  std::vector<float> old(f, f + (long)nActive * nPlanes);
+  Int i;
+#pragma omp parallel for private(i)
+  for (i = 0; i < nActive; i++)
+    std::memcpy(f + (long)newRow[i] * nPlanes, &old[(long)i * nPlanes],
+                sizeof(float) * nPlanes);
+}
 
 template <Int dimension>
 void Metadata<dimension>::getSpatialLocations(/*long*/ at::Tensor spatialSize,
                                               /*long*/ at::Tensor locations) {
   Int nActive = getNActive(spatialSize);
-  auto &SGs = getSparseGrid(spatialSize);
-  Int batchSize = SGs.size();
-
+  auto p = LongTensorToPoint<dimension>(spatialSize);
+  // The cached coordinates are stale if the input sites have changed since;
+  // the grids of the other scales are built from them, and buildOutputGrid
+  // drops the entry of a scale it rebuilds
+  uint64_t hash = inputSGs ? currentInputHash() : 0;
+  at::Tensor t;
+  std::unique_lock<std::mutex> lock(cacheGuard.mutex);
+  auto cached = spatialLocations.find(p);
+  bool found = cached != spatialLocations.end() and
+               cached->second.first == hash and
+               cached->second.second.size(0) == nActive;
+  if (found)
+    t = cached->second.second;
+  lock.unlock();
+  if (not found) {
+    auto &SGs = getSparseGrid(spatialSize);
+    Int batchSize = SGs.size();
+    t = at::CPU(at::kLong).tensor({(long)nActive, dimension + 1});
+    t.zero_();
+    auto lD = t.data<long>();
+    Int i;
+#pragma omp parallel for schedule(dynamic) private(i)
+    for (i = 0; i < batchSize; i++) {
+      auto &mp = SGs[i].mp;
+      auto offset = SGs[i].ctr;
+      for (auto it = mp.begin(); it != mp.end(); ++it) {
+        for (Int d = 0; d < dimension; ++d) {
+          lD[(it->second + offset) * (dimension + 1) + d] = it->first[d];
+        }
+        lD[(it->second + offset) * (dimension + 1) + dimension] = i;
+      }
+    }
+    lock.lock();
+    spatialLocations[p] = std::make_pair(hash, t);
+    lock.unlock();
+  }
   locations.resize_({(int)nActive, dimension + 1});
-  locations.zero_();
+  locations.copy_(t);
+}
+template <Int dimension> uint64_t Metadata<dimension>::inputHash() {
+  finishLookahead();
+  return currentInputHash();
+}
+template <Int dimension> uint64_t Metadata<dimension>::currentInputHash() {
+  assert(inputSGs && "Call setInputSpatialSize first, please!");
+  std::unique_lock<std::mutex> lock(cacheGuard.mutex);
+  if (inputHashKnown)
+    return knownInputHash;
+  lock.unlock();
+  auto &SGs = *inputSGs;
+  Int n = *inputNActive;
+  // The coordinates and sample number of each row
+  std::vector<Int> sites((long)n * (dimension + 1), 0);
+  Int i;
+#pragma omp parallel for schedule(dynamic) private(i)
+  for (i = 0; i < (Int)SGs.size(); i++) {
+    for (auto const &iter : SGs[i].mp) {
+      Int *s = &sites[(long)(iter.second + SGs[i].ctr) * (dimension + 1)];
+      for (Int d = 0; d < dimension; ++d)
+        s[d] = iter.first[d];
+      s[dimension] = i;
+    }
+  }
+  uint64_t hash = fmix64(((uint64_t)dimension << 8) | sizeof(Int));
+  auto mix = [&](uint64_t w) { hash = fmix64(hash ^ w); };
+  mix(sortedRuleBooks);
+  mix(mortonOrdered);
+  for (Int d = 0; d < dimension; ++d)
+    mix(inputSpatialSize[d]);
+  mix(SGs.size());
+  mix(n);
+  for (auto x : sites)
+    mix(x);
+  lock.lock();
+  knownInputHash = hash;
+  inputHashKnown = true;
+  return hash;
+}
+template <Int dimension> std::string Metadata<dimension>::inputKey() {
+  if (not inputSGs)
+    return "";
+  char key[17];
+  std::snprintf(key, sizeof(key), "%016llx",
+                (unsigned long long)inputHash());
+  return key;
+}
 
-  auto lD = locations.data<long>();
+template <Int dimension>
+MetadataFileHeader metadataFileHeader(Metadata<dimension> &m, uint64_t key) {
+  MetadataFileHeader h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, "SCNRULES", 8);
+  h.version = metadataFileVersion;
+  h.dimension = dimension;
+  h.intSize = sizeof(Int);
+  h.flags = m.sortedRuleBooks | m.mortonOrdered << 1;
+  h.key = key;
+  return h;
+}
+template <Int dimension>
+void Metadata<dimension>::writeRuleBooks(MetadataFileWriter &w, uint64_t key) {
+  finishLookahead();
+  w.value(metadataFileHeader(*this, key));
+  w.value(inputSpatialSize);
+  MetadataFile_write(w, nActive);
+  MetadataFile_write(w, grids);
+  MetadataFile_write(w, validRuleBooks);
+  MetadataFile_write(w, ruleBooks);
+  MetadataFile_write(w, inputLayerRuleBook);
+  MetadataFile_write(w, blLayerRuleBook);
+}
+// Whether every row that the grids and rulebooks read into m refer to is that
+// of an active site, and the rulebooks have one set of rules per filter offset
+template <Int dimension>
+bool checkRuleBooks(Metadata<dimension> &m,
+                    const Point<dimension> &inputSpatialSize) {
+  auto nActive = [&](const Point<dimension> &spatialSize) {
+    auto i = m.nActive.find(spatialSize);
+    return i == m.nActive.end() ? -1 : i->second;
+  };
+  for (auto const &g : m.grids)
+    if (not MetadataFile_check(g.second, nActive(g.first)))
+      return false;
+  for (auto const &x : m.validRuleBooks) {
+    Point<dimension> spatialSize;
+    Int filterVolume = 1;
+    for (Int i = 0; i < dimension; i++) {
+      spatialSize[i] = x.first[i];
+      filterVolume *= x.first[i + dimension];
+    }
+    Int n = nActive(spatialSize);
+    if (not x.second.empty() and
+        not MetadataFile_check(x.second, filterVolume, n, n))
+      return false;
+  }
+  for (auto const &x : m.ruleBooks) {
+    Point<dimension> iS, oS;
+    Int filterVolume = 1;
+    for (Int i = 0; i < dimension; i++) {
+      Int size = x.first[i + dimension], stride = x.first[i + 2 * dimension];
+      if (size < 1 or stride < 1 or x.first[i] < size)
+        return false;
+      iS[i] = x.first[i];
+      oS[i] = (iS[i] - size) / stride + 1;
+      filterVolume *= size;
+    }
+    if (not x.second.empty() and
+        not MetadataFile_check(x.second, filterVolume, nActive(iS),
+                               nActive(oS)))
+      return false;
+  }
+  Int n = nActive(inputSpatialSize);
+  return MetadataFile_check(m.inputLayerRuleBook, 4, n) and
+         MetadataFile_check(m.blLayerRuleBook, 5, n);
+}
 
-  for (Int i = 0; i < batchSize; i++) {
-    auto mp = SGs[i].mp;
-    auto offset = SGs[i].ctr;
-    for (auto it = mp.begin(); it != mp.end(); ++it) {
-      for (Int d = 0; d < dimension; ++d) {
-        lD[(it->second + offset) * (dimension + 1) + d] = it->first[d];
+template <Int dimension>
+bool Metadata<dimension>::readRuleBooks(MetadataFileReader &r, bool adopt) {
+  finishLookahead();
+  auto h = r.value<MetadataFileHeader>();
+  auto header = metadataFileHeader(*this, adopt ? 0 : inputHash());
+  if (adopt)
+    header.flags = h.flags;
+  auto spatialSize = r.value<Point<dimension>>();
+  if (not r.ok or std::memcmp(&h, &header, sizeof(h)) or
+      (not adopt and spatialSize != inputSpatialSize))
+    return false;
+  Metadata<dimension> m;
+  MetadataFile_read(r, m.nActive);
+  MetadataFile_read(r, m.grids);
+  for (auto &g : m.grids)
+    g.second.spatialSize = g.first;
+  MetadataFile_read(r, m.validRuleBooks);
+  MetadataFile_read(r, m.ruleBooks);
+  MetadataFile_read(r, m.inputLayerRuleBook);
+  MetadataFile_read(r, m.blLayerRuleBook);
+  // Files may be corrupt, or come from anywhere; segments to adopt come from
+  // serializeRuleBooks in the same program, and checking them would cost more
+  // than adopting them
+  if (not r.ok or r.remaining() or
+      (not adopt and not checkRuleBooks<dimension>(m, spatialSize)))
+    return false;
+  auto &SGs = m.grids[spatialSize];
+  long sample = (long)SGs.size() - 1;
+  if (not adopt) {
+    // The key is only a hash: check that the input sites are numbered the
+    // same
+    if (m.nActive[spatialSize] != *inputNActive or
+        SGs.size() != inputSGs->size())
+      return false;
+    std::vector<char> match(SGs.size());
+    Int i;
+#pragma omp parallel for schedule(dynamic) private(i)
+    for (i = 0; i < (Int)SGs.size(); i++) {
+      auto &mp = (*inputSGs)[i].mp;
+      match[i] = SGs[i].ctr == (*inputSGs)[i].ctr and
+                 SGs[i].mp.size() == mp.size();
+      for (auto const &iter : SGs[i].mp) {
+        if (not match[i])
+          break;
+        auto j = mp.find(iter.first);
+        match[i] = j != mp.end() and j->second == iter.second;
       }
-      lD[(it->second + offset) * (dimension + 1) + dimension] = i;
     }
+    for (auto x : match)
+      if (not x)
+        return false;
+    sample = inputSG ? inputSG - &inputSGs->front() : -1;
+  } else {
+    inputSpatialSize = spatialSize;
+    sortedRuleBooks = h.flags & 1;
+    mortonOrdered = h.flags & 2;
   }
+
+  unpublishRuleBooks();
+  recorded.clear();
+  nActive.swap(m.nActive);
+  grids.swap(m.grids);
+  validRuleBooks.swap(m.validRuleBooks);
+  ruleBooks.swap(m.ruleBooks);
+  inputLayerRuleBook.swap(m.inputLayerRuleBook);
+  blLayerRuleBook.swap(m.blLayerRuleBook);
+  // These refer to the numbering of the sites of the old grids
+  activePoolingRuleBooks.clear();
+  neighbourTables.clear();
+  fullConvolutionRuleBooks.clear();
+  sparseToDenseRuleBooks.clear();
+  spatialLocations.clear();
+  inputHashKnown = false;
+  inputSGs = &grids[inputSpatialSize];
+  inputNActive = &nActive[inputSpatialSize];
+  inputSG = sample >= 0 ? &(*inputSGs)[sample] : nullptr;
+  return true;
+}
+template <Int dimension>
+bool Metadata<dimension>::saveRuleBooks(std::string filename) {
+  MetadataFileWriter w(filename);
+  writeRuleBooks(w, inputHash());
+  return w.close();
+}
+template <Int dimension>
+bool Metadata<dimension>::loadRuleBooks(std::string filename) {
+  if (not inputSGs)
+    return false;
+  MetadataFileReader r(filename);
+  return readRuleBooks(r, false);
+}
+template <Int dimension>
+void Metadata<dimension>::serializeRuleBooks(/*byte*/ at::Tensor bytes) {
+  MetadataFileWriter counter(nullptr);
+  writeRuleBooks(counter, 0);
+  bytes.resize_({(long)counter.size});
+  MetadataFileWriter w((char *)bytes.data<unsigned char>());
+  writeRuleBooks(w, 0);
+}
+template <Int dimension>
+bool Metadata<dimension>::deserializeRuleBooks(/*byte*/ at::Tensor bytes) {
+  // The rulebooks keep bytes alive, and borrow their rules from it
+  MetadataFileReader r((char *)bytes.data<unsigned char>(), bytes.numel(),
+                       std::make_shared<at::Tensor>(bytes));
+  return readRuleBooks(r, true);
 }
 template <Int dimension>
 void Metadata<dimension>::createMetadataForDenseToSparse(
@@ -211,6 +563,7 @@ void Metadata<dimension>::sparsifyMetadata(Metadata<dimension> &mOut,
                                            /*long*/ at::Tensor spatialSize,
                                            /*byte*/ at::Tensor filter,
                                            /*long*/ at::Tensor cuSum) {
+  finishLookahead();
   // Create a new SparseGrids with fewer entries.
   mOut.clear();
   auto p = LongTensorToPoint<dimension>(spatialSize);
@@ -247,6 +600,8 @@ void Metadata<dimension>::addSampleFromThresholdedTensor(
     /*float*/ at::Tensor tensor_,
     /*long*/ at::Tensor offset_,
     /*long*/ at::Tensor spatialSize_, float threshold) {
+  finishLookahead();
+  inputHashKnown = false;
 
   auto &nActive = *inputNActive;
   auto &SGs = *inputSGs;
@@ -298,6 +653,7 @@ void Metadata<dimension>::addSampleFromThresholdedTensor(
 
 // 3x3 submanifold convolutions, 3x3/2x2 pooling or strided convolutions
 template <Int dimension> void Metadata<dimension>::generateRuleBooks3s2() {
+  finishLookahead();
   long sz[dimension], str[dimension], inS[dimension], outS[dimension];
   Point<dimension> p1;
   Point<2 * dimension> p2;
@@ -311,7 +667,7 @@ template <Int dimension> void Metadata<dimension>::generateRuleBooks3s2() {
     auto &SGs = grids[p1];
     auto &rb = validRuleBooks[p2];
     if (rb.empty())
-      SubmanifoldConvolution_SgsToRules(SGs, rb, sz);
+      buildSubmanifoldRuleBook(rb, SGs, sz, true);
     for (Int i = 0; i < dimension; ++i)
       if (p1[i] < 3 or p1[i] % 2 != 1)
         return;
@@ -320,8 +676,7 @@ template <Int dimension> void Metadata<dimension>::generateRuleBooks3s2() {
     auto &SGs2 = grids[p1];
     auto &rb2 = ruleBooks[p3];
     if (rb2.empty())
-      nActive[p1] = Convolution_InputSgsToRulesAndOutputSgs(SGs, SGs2, rb2, sz,
-                                                            str, inS, outS);
+      nActive[p1] = buildRuleBook(rb2, SGs, SGs2, sz, str, inS, outS, true);
     for (Int i = 0; i < dimension; ++i)
       p2[i] = p3[i] = inS[i] = outS[i];
   }
@@ -329,6 +684,7 @@ template <Int dimension> void Metadata<dimension>::generateRuleBooks3s2() {
 
 // 3x3 submanifold convolutions, 2x2 pooling or strided convolutions
 template <Int dimension> void Metadata<dimension>::generateRuleBooks2s2() {
+  finishLookahead();
   long s2[dimension], s3[dimension], inS[dimension], outS[dimension];
   Point<dimension> p1;
   Point<2 * dimension> p2;
@@ -342,7 +698,7 @@ template <Int dimension> void Metadata<dimension>::generateRuleBooks2s2() {
     auto &SGs = grids[p1];
     auto &rb = validRuleBooks[p2];
     if (rb.empty())
-      SubmanifoldConvolution_SgsToRules(SGs, rb, s3);
+      buildSubmanifoldRuleBook(rb, SGs, s3, true);
     for (Int i = 0; i < dimension; ++i)
       if (p1[i] < 2 or p1[i] % 2 != 0)
         return;
@@ -351,8 +707,7 @@ template <Int dimension> void Metadata<dimension>::generateRuleBooks2s2() {
     auto &SGs2 = grids[p1];
     auto &rb2 = ruleBooks[p3];
     if (rb2.empty())
-      nActive[p1] = Convolution_InputSgsToRulesAndOutputSgs(SGs, SGs2, rb2, s2,
-                                                            s2, inS, outS);
+      nActive[p1] = buildRuleBook(rb2, SGs, SGs2, s2, s2, inS, outS, true);
     for (Int i = 0; i < dimension; ++i)
       p2[i] = p3[i] = inS[i] = outS[i];
   }
@@ -383,47 +738,228 @@ void Metadata<dimension>::blLayer(/*long*/ at::Tensor spatialSize,
                      coords.size(0), coords.size(1), mode, *inputNActive);
 }
 template <Int dimension>
+void Metadata<dimension>::buildSubmanifoldRuleBook(RuleBook &rb,
+                                                   SparseGrids<dimension> &SGs,
+                                                   long *size, bool openMP) {
+  if (sortedRuleBooks)
+    SubmanifoldConvolution_SgsToRules_Sorted(SGs, rb, size, openMP);
+  else if (SubmanifoldConvolution_HalfStencil<dimension>(size))
+    SubmanifoldConvolution_SgsToRules_HalfStencil(SGs, rb, size, openMP);
+  else
+#if defined(ENABLE_OPENMP)
+      openMP ? SubmanifoldConvolution_SgsToRules_OMP(SGs, rb, size) :
+#endif
+             SubmanifoldConvolution_SgsToRules(SGs, rb, size);
+}
+template <Int dimension>
+bool Metadata<dimension>::deriveSubmanifoldRuleBook(
+    RuleBook &rb, SparseGrids<dimension> &SGs, const Point<2 * dimension> &key,
+    bool openMP) {
+  const RuleBook *larger = nullptr, *smaller = nullptr;
+  long largerSize[dimension], smallerSize[dimension], size[dimension];
+  Int smallerVolume = 0;
+  for (Int i = 0; i < dimension; i++)
+    size[i] = key[i + dimension];
+  // The sorted builders order the rules differently
+  auto nt = neighbourTables.published(key);
+  if (nt and not sortedRuleBooks) {
+    SubmanifoldConvolution_NeighboursToRules<dimension>(
+        SGs, *nt, volume<dimension>(size), rb, openMP);
+    return true;
+  }
+  validRuleBooks.forEachPublished([&](const Point<2 * dimension> &k,
+                                      const RuleBook &r) {
+    bool sameSpatialSize = true, contains = true, contained = true;
+    Int v = 1;
+    for (Int i = 0; i < dimension; i++) {
+      sameSpatialSize = sameSpatialSize and k[i] == key[i];
+      contains = contains and k[i + dimension] >= key[i + dimension];
+      contained = contained and k[i + dimension] <= key[i + dimension];
+      v *= k[i + dimension];
+    }
+    if (not sameSpatialSize or r.empty())
+      return;
+    if (contains and not larger) {
+      larger = &r;
+      for (Int i = 0; i < dimension; i++)
+        largerSize[i] = k[i + dimension];
+    } else if (contained and v > smallerVolume) {
+      smaller = &r;
+      smallerVolume = v;
+      for (Int i = 0; i < dimension; i++)
+        smallerSize[i] = k[i + dimension];
+    }
+  });
+  if (larger) {
+    SubmanifoldConvolution_SelectRules<dimension>(*larger, rb, largerSize, size,
+                                                  openMP);
+    return true;
+  }
+  // The sorted builders order the rules differently. Extending looks up the
+  // offsets that smaller lacks; only do so if there are fewer of them than
+  // the sd / 2 + 1 offsets up to the centre that the half-stencil builder
+  // looks up, so that 3x3x5 comes from 3x3x3 but 5x5x5 is built afresh.
+  Int sd = volume<dimension>(size);
+  if (smaller and not sortedRuleBooks and sd - smallerVolume < sd / 2 + 1) {
+    SubmanifoldConvolution_ExtendRules<dimension>(SGs, *smaller, rb,
+                                                  smallerSize, size, openMP);
+    return true;
+  }
+  return false;
+}
+template <Int dimension>
+template <typename Cache, typename Build>
+typename Cache::mapped_type &
+Metadata<dimension>::getCached(Cache &cache,
+                               const typename Cache::key_type &key,
+                               const Point<dimension> &inputSpatialSize,
+                               Build build) {
+  if (auto published = cache.published(key))
+    return *published;
+  std::unique_lock<std::mutex> lock(cacheGuard.mutex);
+  auto &entry = cache[key];
+  auto &SGs = grids[inputSpatialSize];
+  lock.unlock();
+  lookahead.wait(&entry);
+  lookahead.wait(&SGs);
+  lock.lock();
+  if (cacheGuard.claim(lock, entry)) {
+    cacheGuard.wait(lock, &SGs);
+    lock.unlock();
+    build(entry, SGs);
+    lock.lock();
+    cacheGuard.release(&entry);
+  }
+  cache.publish(key, &entry);
+  return entry;
+}
+template <Int dimension>
+template <typename Build>
+void Metadata<dimension>::buildOutputGrid(
+    const Point<dimension> &outputSpatialSize, bool exclusive, Build build) {
+  std::unique_lock<std::mutex> lock(cacheGuard.mutex);
+  auto &oSGs = grids[outputSpatialSize];
+  auto &n = nActive[outputSpatialSize];
+  // Building a strided rulebook rewrites its output grid, so let the
+  // lookahead requests that use it finish first
+  lock.unlock();
+  lookahead.waitForUses(&oSGs);
+  lock.lock();
+  spatialLocations.erase(outputSpatialSize);
+  cacheGuard.wait(lock, &oSGs);
+  cacheGuard.building.insert(&oSGs);
+  cacheGuard.building.insert(&n);
+  if (not exclusive)
+    lock.unlock();
+  Int count = build(oSGs);
+  if (not exclusive)
+    lock.lock();
+  n = count;
+  cacheGuard.release(&oSGs);
+  cacheGuard.release(&n);
+}
+template <Int dimension>
 RuleBook &
 Metadata<dimension>::getSubmanifoldRuleBook(/*long*/ at::Tensor spatialSize,
                                             /*long*/ at::Tensor size,
                                             bool openMP) {
   auto p = TwoLongTensorsToPoint<dimension>(spatialSize, size);
-  auto &rb = validRuleBooks[p];
-  if (rb.empty()) {
-    auto &SGs = grids[LongTensorToPoint<dimension>(spatialSize)];
-#if defined(ENABLE_OPENMP)
-    openMP ? SubmanifoldConvolution_SgsToRules_OMP(SGs, rb, size.data<long>()) :
-#endif
-           SubmanifoldConvolution_SgsToRules(SGs, rb, size.data<long>());
+  auto &rb = getCached(validRuleBooks, p,
+                       LongTensorToPoint<dimension>(spatialSize),
+                       [&](RuleBook &rb, SparseGrids<dimension> &SGs) {
+                         if (not deriveSubmanifoldRuleBook(rb, SGs, p, openMP))
+                           buildSubmanifoldRuleBook(rb, SGs, size.data<long>(),
+                                                    openMP);
+                       });
+  if (recording) {
+    long stride[dimension];
+    std::fill(stride, stride + dimension, 1);
+    record(submanifoldRuleBook, spatialSize.data<long>(),
+           spatialSize.data<long>(), size.data<long>(), stride, &rb);
   }
   return rb;
 }
 template <Int dimension>
-RuleBook &
+NeighbourTable &Metadata<dimension>::getSubmanifoldNeighbourTable(
+    /*long*/ at::Tensor spatialSize, /*long*/ at::Tensor size, bool openMP) {
+  auto p = TwoLongTensorsToPoint<dimension>(spatialSize, size);
+  auto build = [&](NeighbourTable &nt, SparseGrids<dimension> &SGs) {
+    // Read a published rulebook rather than look the neighbours up again
+    if (auto rb = validRuleBooks.published(p))
+      SubmanifoldConvolution_RulesToNeighbours(*rb, nt,
+                                               getNActive(spatialSize));
+    else
+      SubmanifoldConvolution_SgsToNeighbours<dimension>(SGs, nt,
+                                                        size.data<long>(),
+                                                        openMP);
+  };
+  auto &nt = getCached(neighbourTables, p,
+                       LongTensorToPoint<dimension>(spatialSize), build);
+  if (recording) {
+    long stride[dimension];
+    std::fill(stride, stride + dimension, 1);
+    record(neighbourTable, spatialSize.data<long>(), spatialSize.data<long>(),
+           size.data<long>(), stride, &nt);
+  }
+  return nt;
+}
+template <Int dimension>
+TableRuleBook &
 Metadata<dimension>::getActivePoolingRuleBook(/*long*/ at::Tensor spatialSize) {
   auto spatialSz = LongTensorToPoint<dimension>(spatialSize);
-  auto &SGs = grids[spatialSz];
-  auto &rb = activePoolingRuleBooks[spatialSz];
-  if (rb.empty())
-    activePoolingRules(SGs, rb);
-  return rb;
+  return getCached(activePoolingRuleBooks, spatialSz, spatialSz,
+                   [&](TableRuleBook &rb, SparseGrids<dimension> &SGs) {
+                     activePoolingRules(SGs, rb);
+                   });
+}
+template <Int dimension>
+void Metadata<dimension>::buildSparseToDenseRuleBook(
+    RuleBook &rb, SparseGrids<dimension> &SGs, long *spatialSize,
+    bool openMP) {
+#if defined(ENABLE_OPENMP)
+  openMP ? SparseToDense_InputSgsToRulesAndOutputSgs_OMP(SGs, rb, spatialSize)
+         :
+#endif
+         SparseToDense_InputSgsToRulesAndOutputSgs(SGs, rb, spatialSize);
 }
 template <Int dimension>
 RuleBook &
 Metadata<dimension>::getSparseToDenseRuleBook(/*long*/ at::Tensor spatialSize,
                                               bool openMP) {
   auto ss = LongTensorToPoint<dimension>(spatialSize);
-  auto &SGs = grids[ss];
-  auto &rb = sparseToDenseRuleBooks[ss];
-  if (rb.empty())
+  auto s = spatialSize.data<long>();
+  auto &rb = getCached(sparseToDenseRuleBooks, ss, ss,
+                       [&](RuleBook &rb, SparseGrids<dimension> &SGs) {
+                         buildSparseToDenseRuleBook(rb, SGs, s, openMP);
+                       });
+  record(sparseToDenseRuleBook, s, s, s, s, &rb);
+  return rb;
+}
+template <Int dimension>
+Int Metadata<dimension>::buildRuleBook(RuleBook &rb,
+                                       SparseGrids<dimension> &iSGs,
+                                       SparseGrids<dimension> &oSGs, long *size,
+                                       long *stride, long *inputSpatialSize,
+                                       long *outputSpatialSize, bool openMP) {
+  Int n;
+  if (sortedRuleBooks)
+    n = Convolution_InputSgsToRulesAndOutputSgs_Sorted(
+        iSGs, oSGs, rb, size, stride, inputSpatialSize, outputSpatialSize,
+        openMP);
+  else
+    n =
 #if defined(ENABLE_OPENMP)
-    openMP ? SparseToDense_InputSgsToRulesAndOutputSgs_OMP(
-                 SGs, rb, spatialSize.data<long>())
-           :
+        openMP ? Convolution_InputSgsToRulesAndOutputSgs_OMP(
+                     iSGs, oSGs, rb, size, stride, inputSpatialSize,
+                     outputSpatialSize)
+               :
 #endif
-           SparseToDense_InputSgsToRulesAndOutputSgs(SGs, rb,
-                                                     spatialSize.data<long>());
-  return rb;
+               Convolution_InputSgsToRulesAndOutputSgs(
+                   iSGs, oSGs, rb, size, stride, inputSpatialSize,
+                   outputSpatialSize);
+  if (mortonOrdered)
+    MortonOrder_renumberOutputs(oSGs, rb, n);
+  return n;
 }
 template <Int dimension>
 RuleBook &
@@ -432,24 +968,19 @@ Metadata<dimension>::getRuleBook(/*long*/ at::Tensor inputSpatialSize,
                                  /*long*/ at::Tensor size,
                                  /*long*/ at::Tensor stride, bool openMP) {
   auto p = ThreeLongTensorsToPoint<dimension>(inputSpatialSize, size, stride);
-  auto &rb = ruleBooks[p];
-  if (rb.empty()) {
-    auto iS = LongTensorToPoint<dimension>(inputSpatialSize);
-    auto oS = LongTensorToPoint<dimension>(outputSpatialSize);
-    auto &iSGs = grids[iS];
-    auto &oSGs = grids[oS];
-    nActive[oS] =
-#if defined(ENABLE_OPENMP)
-        openMP
-            ? Convolution_InputSgsToRulesAndOutputSgs_OMP(
-                  iSGs, oSGs, rb, size.data<long>(), stride.data<long>(),
-                  inputSpatialSize.data<long>(), outputSpatialSize.data<long>())
-            :
-#endif
-            Convolution_InputSgsToRulesAndOutputSgs(
-                iSGs, oSGs, rb, size.data<long>(), stride.data<long>(),
-                inputSpatialSize.data<long>(), outputSpatialSize.data<long>());
-  }
+  auto oS = LongTensorToPoint<dimension>(outputSpatialSize);
+  auto build = [&](RuleBook &rb, SparseGrids<dimension> &iSGs) {
+    buildOutputGrid(oS, false, [&](SparseGrids<dimension> &oSGs) {
+      return buildRuleBook(rb, iSGs, oSGs, size.data<long>(),
+                           stride.data<long>(), inputSpatialSize.data<long>(),
+                           outputSpatialSize.data<long>(), openMP);
+    });
+  };
+  auto &rb = getCached(ruleBooks, p,
+                       LongTensorToPoint<dimension>(inputSpatialSize), build);
+  record(convolutionRuleBook, inputSpatialSize.data<long>(),
+         outputSpatialSize.data<long>(), size.data<long>(),
+         stride.data<long>(), &rb);
   return rb;
 }
 template <Int dimension>
@@ -459,22 +990,43 @@ RuleBook &Metadata<dimension>::getFullConvolutionRuleBook(
     /*long*/ at::Tensor size,
     /*long*/ at::Tensor stride, Metadata<dimension> &newM) {
   auto p = ThreeLongTensorsToPoint<dimension>(inputSpatialSize, size, stride);
-  auto &rb = fullConvolutionRuleBooks[p];
-  if (rb.empty()) {
+  auto iS = LongTensorToPoint<dimension>(inputSpatialSize);
+  auto build = [&](RuleBook &rb, SparseGrids<dimension> &SGs) {
     newM.clear();
-    auto iS = LongTensorToPoint<dimension>(inputSpatialSize);
     auto oS = LongTensorToPoint<dimension>(outputSpatialSize);
-    newM.grids[iS] = grids[iS]; // copy
-    newM.nActive[iS] = nActive[iS];
+    newM.grids[iS] = SGs; // copy
+    newM.nActive[iS] = getNActive(inputSpatialSize);
     auto &iSGs = newM.grids[iS];
     auto &oSGs = newM.grids[oS];
     newM.nActive[oS] = FullConvolution_InputSgsToRulesAndOutputSgs_OMP(
         iSGs, oSGs, rb, size.data<long>(), stride.data<long>(),
         inputSpatialSize.data<long>(), outputSpatialSize.data<long>());
-  }
-  return rb;
+    newM.mortonOrdered = mortonOrdered;
+    if (mortonOrdered)
+      MortonOrder_renumberOutputs(oSGs, rb, newM.nActive[oS]);
+  };
+  return getCached(fullConvolutionRuleBooks, p, iS, build);
 }
 
+template <Int dimension>
+Int Metadata<dimension>::buildRandomizedStrideRuleBook(
+    RuleBook &rb, SparseGrids<dimension> &iSGs, SparseGrids<dimension> &oSGs,
+    long *size, long *stride, long *inputSpatialSize, long *outputSpatialSize,
+    bool openMP) {
+  Int n =
+#if defined(ENABLE_OPENMP)
+      openMP ? RSR_InputSgsToRulesAndOutputSgs_OMP(iSGs, oSGs, rb, size, stride,
+                                                   inputSpatialSize,
+                                                   outputSpatialSize, re)
+             :
+#endif
+             RSR_InputSgsToRulesAndOutputSgs(iSGs, oSGs, rb, size, stride,
+                                             inputSpatialSize,
+                                             outputSpatialSize, re);
+  if (mortonOrdered)
+    MortonOrder_renumberOutputs(oSGs, rb, n);
+  return n;
+}
 template <Int dimension>
 RuleBook &Metadata<dimension>::getRandomizedStrideRuleBook(
     /*long*/ at::Tensor inputSpatialSize,
@@ -482,29 +1034,225 @@ RuleBook &Metadata<dimension>::getRandomizedStrideRuleBook(
     /*long*/ at::Tensor size,
     /*long*/ at::Tensor stride, bool openMP) {
   auto p = ThreeLongTensorsToPoint<dimension>(inputSpatialSize, size, stride);
-  auto &rb = ruleBooks[p];
-  if (rb.empty()) {
-    auto iS = LongTensorToPoint<dimension>(inputSpatialSize);
-    auto oS = LongTensorToPoint<dimension>(outputSpatialSize);
-    auto &iSGs = grids[iS];
-    auto &oSGs = grids[oS];
-    nActive[oS] =
-#if defined(ENABLE_OPENMP)
-        openMP
-            ? RSR_InputSgsToRulesAndOutputSgs_OMP(
-                  iSGs, oSGs, rb, size.data<long>(), stride.data<long>(),
-                  inputSpatialSize.data<long>(), outputSpatialSize.data<long>(),
-                  re)
-            :
-#endif
-            RSR_InputSgsToRulesAndOutputSgs(iSGs, oSGs, rb, size.data<long>(),
-                                            stride.data<long>(),
-                                            inputSpatialSize.data<long>(),
-                                            outputSpatialSize.data<long>(), re);
-  }
+  auto oS = LongTensorToPoint<dimension>(outputSpatialSize);
+  auto build = [&](RuleBook &rb, SparseGrids<dimension> &iSGs) {
+    buildOutputGrid(oS, true, [&](SparseGrids<dimension> &oSGs) {
+      return buildRandomizedStrideRuleBook(
+          rb, iSGs, oSGs, size.data<long>(), stride.data<long>(),
+          inputSpatialSize.data<long>(), outputSpatialSize.data<long>(),
+          openMP);
+    });
+  };
+  auto &rb = getCached(ruleBooks, p,
+                       LongTensorToPoint<dimension>(inputSpatialSize), build);
+  record(randomizedStrideRuleBook, inputSpatialSize.data<long>(),
+         outputSpatialSize.data<long>(), size.data<long>(),
+         stride.data<long>(), &rb);
   return rb;
 }
 
+template <Int dimension>
+Int Metadata<dimension>::planRuleBooks(
+    long *plan, Int nRows, std::vector<RuleBookRequest<dimension>> &requests) {
+  // Each request goes in the wave after the one that builds its input grid,
+  // and after any earlier use of the grid it builds. The cache entries are
+  // all created up front, so the requests in a wave can be built in parallel.
+  std::unordered_map<Point<dimension>, Int, IntArrayHash<dimension>> ready,
+      lastUse;
+  // Keyed by the rulebook, or for neighbour tables the rulebook they go with
+  std::unordered_map<RuleBook *, Int> requested;
+  Int nWaves = 0;
+  requests.clear();
+  for (Int j = 0; j < nRows; j++) {
+    RuleBookRequest<dimension> r;
+    long *row = plan + j * (1 + 4 * dimension);
+    r.kind = row[0];
+    r.inputSpatialSize = row + 1;
+    r.outputSpatialSize = row + 1 + dimension;
+    r.size = row + 1 + 2 * dimension;
+    r.stride = row + 1 + 3 * dimension;
+    Point<dimension> iS, oS;
+    Point<2 * dimension> p2;
+    Point<3 * dimension> p3;
+    for (Int i = 0; i < dimension; i++) {
+      iS[i] = p2[i] = p3[i] = r.inputSpatialSize[i];
+      oS[i] = r.outputSpatialSize[i];
+      p2[i + dimension] = p3[i + dimension] = r.size[i];
+      p3[i + 2 * dimension] = r.stride[i];
+    }
+    // Skip requests on grids that neither exist nor come from the plan
+    if (not grids.count(iS) and not ready.count(iS))
+      continue;
+    r.iSGs = &grids[iS];
+    r.iNActive = &nActive[iS];
+    r.oSGs = nullptr;
+    r.nt = nullptr;
+    RuleBook *key;
+    if (r.kind == submanifoldRuleBook or r.kind == neighbourTable) {
+      key = &validRuleBooks[p2];
+      // Neighbour tables are looked up without building the rulebook
+      r.rb = r.kind == submanifoldRuleBook ? key : nullptr;
+      if (r.kind == neighbourTable)
+        r.nt = &neighbourTables[p2];
+    } else if (r.kind == convolutionRuleBook or
+               r.kind == randomizedStrideRuleBook) {
+      key = r.rb = &ruleBooks[p3];
+      r.oSGs = &grids[oS];
+      r.oNActive = &nActive[oS];
+    } else if (r.kind == sparseToDenseRuleBook) {
+      key = r.rb = &sparseToDenseRuleBooks[iS];
+    } else {
+      continue;
+    }
+    if ((not r.rb or not r.rb->empty()) and (not r.nt or not r.nt->empty()))
+      continue;
+    // The rulebook and neighbour table of a submanifold convolution are built
+    // by one request
+    auto dup = requested.find(key);
+    if (dup != requested.end()) {
+      auto &d = requests[dup->second];
+      if (r.rb)
+        d.rb = r.rb;
+      if (r.nt) {
+        d.kind = neighbourTable;
+        d.nt = r.nt;
+      }
+      continue;
+    }
+    r.wave = ready[iS];
+    if (r.oSGs) {
+      r.wave = std::max(r.wave, lastUse[oS] + 1);
+      ready[oS] = r.wave + 1;
+      lastUse[oS] = r.wave;
+    }
+    lastUse[iS] = std::max(lastUse[iS], r.wave);
+    nWaves = std::max(nWaves, r.wave + 1);
+    requested[key] = requests.size();
+    requests.push_back(r);
+  }
+  return nWaves;
+}
+template <Int dimension>
+void Metadata<dimension>::buildRuleBookRequest(RuleBookRequest<dimension> &r,
+                                               bool openMP) {
+  if (r.kind == convolutionRuleBook) {
+    *r.oNActive =
+        buildRuleBook(*r.rb, *r.iSGs, *r.oSGs, r.size, r.stride,
+                      r.inputSpatialSize, r.outputSpatialSize, openMP);
+  } else if (r.kind == randomizedStrideRuleBook) {
+    *r.oNActive = buildRandomizedStrideRuleBook(
+        *r.rb, *r.iSGs, *r.oSGs, r.size, r.stride, r.inputSpatialSize,
+        r.outputSpatialSize, openMP);
+  } else if (r.kind == sparseToDenseRuleBook) {
+    buildSparseToDenseRuleBook(*r.rb, *r.iSGs, r.inputSpatialSize, openMP);
+  } else {
+    // The neighbour table first, as the rulebook can be read out of it
+    if (r.nt and r.nt->empty())
+      SubmanifoldConvolution_SgsToNeighbours<dimension>(*r.iSGs, *r.nt, r.size,
+                                                        openMP);
+    if (r.rb and r.rb->empty()) {
+      if (r.nt and not sortedRuleBooks)
+        SubmanifoldConvolution_NeighboursToRules<dimension>(
+            *r.iSGs, *r.nt, volume<dimension>(r.size), *r.rb, openMP);
+      else
+        buildSubmanifoldRuleBook(*r.rb, *r.iSGs, r.size, openMP);
+    }
+  }
+}
+template <Int dimension>
+void Metadata<dimension>::precomputeRuleBooks(/*long*/ at::Tensor plan) {
+  assert(plan.ndimension() == 2 and plan.size(1) == 1 + 4 * dimension);
+  finishLookahead();
+  std::vector<RuleBookRequest<dimension>> requests;
+  Int nWaves = planRuleBooks(plan.data<long>(), plan.size(0), requests);
+  for (Int w = 0; w < nWaves; w++) {
+    std::vector<Int> wave;
+    for (Int j = 0; j < (Int)requests.size(); j++)
+      if (requests[j].wave == w and
+          requests[j].kind != randomizedStrideRuleBook)
+        wave.push_back(j);
+    // With several requests, each is built by one thread
+    Int j;
+#pragma omp parallel for schedule(dynamic) private(j) if (wave.size() > 1)
+    for (j = 0; j < (Int)wave.size(); j++)
+      buildRuleBookRequest(requests[wave[j]], true);
+    // These share the random number generator
+    for (auto &r : requests)
+      if (r.wave == w and r.kind == randomizedStrideRuleBook)
+        buildRuleBookRequest(r, true);
+  }
+}
+
+template <Int dimension>
+void Metadata<dimension>::startLookahead(/*long*/ at::Tensor plan) {
+  assert(plan.ndimension() == 2 and plan.size(1) == 1 + 4 * dimension);
+  finishLookahead();
+  lookahead.index.clear();
+  lookahead.lastUse.clear();
+  lookaheadPlan.assign(plan.data<long>(), plan.data<long>() + plan.numel());
+  planRuleBooks(lookaheadPlan.data(), plan.size(0), lookaheadRequests);
+  if (lookaheadRequests.empty())
+    return;
+  // The requests run in plan order, so their outputs are ready in the order
+  // that the network asks for them
+  for (Int j = 0; j < (Int)lookaheadRequests.size(); j++) {
+    auto &r = lookaheadRequests[j];
+    if (r.rb)
+      lookahead.index[r.rb] = j;
+    if (r.nt)
+      lookahead.index[r.nt] = j;
+    if (r.oSGs) {
+      lookahead.index[r.oSGs] = j;
+      lookahead.index[r.oNActive] = j;
+      lookahead.lastUse[r.oSGs] = j;
+    }
+    lookahead.lastUse[r.iSGs] = j;
+  }
+  // The thread leaves OpenMP to the layers running in the meantime
+  lookahead.start(lookaheadRequests.size(), [this](Int j) {
+    buildRuleBookRequest(lookaheadRequests[j], false);
+  });
+}
+template <Int dimension> void Metadata<dimension>::finishLookahead() {
+  lookahead.join();
+  lookaheadRequests.clear();
+}
+template <Int dimension>
+void Metadata<dimension>::recordRuleBooks(bool record) {
+  recording = record;
+  // So that the getters see the entries asked for again
+  unpublishRuleBooks();
+}
+template <Int dimension> void Metadata<dimension>::unpublishRuleBooks() {
+  activePoolingRuleBooks.unpublish();
+  validRuleBooks.unpublish();
+  neighbourTables.unpublish();
+  ruleBooks.unpublish();
+  fullConvolutionRuleBooks.unpublish();
+  sparseToDenseRuleBooks.unpublish();
+}
+template <Int dimension>
+void Metadata<dimension>::getRecordedPlan(/*long*/ at::Tensor plan) {
+  Int n = recordedPlan.size() / (1 + 4 * dimension);
+  plan.resize_({n, 1 + 4 * dimension});
+  if (n)
+    std::memcpy(plan.data<long>(), &recordedPlan[0],
+                sizeof(long) * recordedPlan.size());
+}
+template <Int dimension>
+void Metadata<dimension>::record(Int kind, long *inputSpatialSize,
+                                 long *outputSpatialSize, long *size,
+                                 long *stride, const void *entry) {
+  if (not recording)
+    return;
+  std::lock_guard<std::mutex> lock(cacheGuard.mutex);
+  if (not recorded.insert(entry).second)
+    return;
+  recordedPlan.push_back(kind);
+  for (auto p : {inputSpatialSize, outputSpatialSize, size, stride})
+    recordedPlan.insert(recordedPlan.end(), p, p + dimension);
+}
+
 template <Int dimension> Int volume(long *point) {
   Int v = 1;
   for (Int i = 0; i < dimension; i++)
@@ -7,6 +7,10 @@
 #ifndef Metadata_H
 #define Metadata_H
 #include "32bits.h"
+#include "LookaheadWorker.h"
+#include "RuleBook.h"
+#include "RuleBookCache.h"
+#include "SparseGridMap.h"
 #include <array>
 #include <chrono>
 #include <cstdint>
@@ -15,20 +19,82 @@
 #include <random>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
-template <Int dimension>
-using SparseGridMap =
-    google::dense_hash_map<Point<dimension>, Int, IntArrayHash<dimension>,
-                           std::equal_to<Point<dimension>>>;
+class MetadataFileWriter;
+class MetadataFileReader;
+
 template <Int dimension> class SparseGrid {
 public:
   Int ctr;
   SparseGridMap<dimension> mp;
   SparseGrid();
 };
-template <Int dimension> using SparseGrids = std::vector<SparseGrid<dimension>>;
-using RuleBook = std::vector<std::vector<Int>>;
+// The grids of the samples of a batch at one spatial size. The grids added by
+// resize index their points directly when spatialSize is small (see
+// SparseGridMap::setSpatialSize); it is all zeros if unknown.
+template <Int dimension>
+class SparseGrids : public std::vector<SparseGrid<dimension>> {
+public:
+  Point<dimension> spatialSize;
+  SparseGrids() { spatialSize.fill(0); }
+  void resize(std::size_t n) {
+    std::size_t m = this->size();
+    std::vector<SparseGrid<dimension>>::resize(n);
+    for (; m < n; m++)
+      (*this)[m].mp.setSpatialSize(spatialSize);
+  }
+};
+
+// Metadata::grids, keyed by spatial size
+template <Int dimension>
+class SparseGridsMap
+    : public std::unordered_map<Point<dimension>, SparseGrids<dimension>,
+                                IntArrayHash<dimension>> {
+public:
+  SparseGrids<dimension> &operator[](const Point<dimension> &spatialSize) {
+    auto r = this->emplace(spatialSize, SparseGrids<dimension>());
+    if (r.second)
+      r.first->second.spatialSize = spatialSize;
+    return r.first->second;
+  }
+};
+
+// The input/output layer and active pooling rulebooks are not indexed by
+// filter offset; they hold a header row followed by a table (see
+// IOLayersRules.h and ActivePoolingRules.h).
+using TableRuleBook = std::vector<std::vector<Int>>;
+
+// nActive x filterVolume input rows for submanifold convolutions, -1 where a
+// neighbour is missing (see SubmanifoldConvolutionRules.h). It holds the same
+// rules as the rulebook, and is looked up without building that, so a layer
+// that only needs the table does not keep both. nRules counts the entries
+// that are not -1.
+class NeighbourTable : public std::vector<Int> {
+public:
+  long nRules = 0;
+};
+
+// Kinds of request in the plans taken by Metadata::precomputeRuleBooks; the
+// same numbers are used in sparseconvnet/utils.py
+enum RuleBookKind {
+  submanifoldRuleBook = 0,
+  neighbourTable = 1,
+  convolutionRuleBook = 2,
+  randomizedStrideRuleBook = 3,
+  sparseToDenseRuleBook = 4
+};
+
+// One request of a precomputeRuleBooks plan, with the cache entries it fills
+template <Int dimension> struct RuleBookRequest {
+  Int kind, wave;
+  long *inputSpatialSize, *outputSpatialSize, *size, *stride;
+  SparseGrids<dimension> *iSGs, *oSGs;
+  Int *iNActive, *oNActive;
+  RuleBook *rb;
+  NeighbourTable *nt;
+};
 
 template <Int dimension>
 void addPointToSparseGridMapAndFeatures(SparseGridMap<dimension> &mp,
@@ -43,39 +109,68 @@ public:
   std::unordered_map<Point<dimension>, Int, IntArrayHash<dimension>> nActive;
 
   // Hash tables for each scale locating the active points
-  std::unordered_map<Point<dimension>, SparseGrids<dimension>,
-                     IntArrayHash<dimension>>
-      grids;
+  SparseGridsMap<dimension> grids;
 
-  std::unordered_map<Point<dimension>, RuleBook, IntArrayHash<dimension>>
+  RuleBookCache<Point<dimension>, TableRuleBook, IntArrayHash<dimension>>
       activePoolingRuleBooks;
 
-  RuleBook inputLayerRuleBook;
-  RuleBook blLayerRuleBook;
+  TableRuleBook inputLayerRuleBook;
+  TableRuleBook blLayerRuleBook;
 
-  std::unordered_map<Point<2 * dimension>, RuleBook,
-                     IntArrayHash<2 * dimension>>
+  RuleBookCache<Point<2 * dimension>, RuleBook, IntArrayHash<2 * dimension>>
       validRuleBooks;
 
-  std::unordered_map<Point<3 * dimension>, RuleBook,
-                     IntArrayHash<3 * dimension>>
+  RuleBookCache<Point<2 * dimension>, NeighbourTable,
+                IntArrayHash<2 * dimension>>
+      neighbourTables;
+
+  RuleBookCache<Point<3 * dimension>, RuleBook, IntArrayHash<3 * dimension>>
       ruleBooks;
 
-  std::unordered_map<Point<3 * dimension>, RuleBook,
-                     IntArrayHash<3 * dimension>>
+  RuleBookCache<Point<3 * dimension>, RuleBook, IntArrayHash<3 * dimension>>
       fullConvolutionRuleBooks;
 
-  std::unordered_map<Point<dimension>, RuleBook, IntArrayHash<dimension>>
+  RuleBookCache<Point<dimension>, RuleBook, IntArrayHash<dimension>>
       sparseToDenseRuleBooks;
 
+  // getSpatialLocations for each scale, with the inputHash of the input sites
+  // it was read for
+  std::unordered_map<Point<dimension>, std::pair<uint64_t, at::Tensor>,
+                     IntArrayHash<dimension>>
+      spatialLocations;
+
   Point<dimension> inputSpatialSize;
   SparseGrids<dimension> *inputSGs;
   SparseGrid<dimension> *inputSG;
   Int *inputNActive;
   std::default_random_engine re;
+  // Build submanifold and strided rulebooks by sorting and merging instead of
+  // hash lookups (see SortedRules.h)
+  bool sortedRuleBooks;
+  // Number the active sites of every scale in Morton order (see MortonOrder.h)
+  bool mortonOrdered;
+  // inputHash(), if inputHashKnown; the functions that change the input sites
+  // or the options above forget it
+  uint64_t knownInputHash;
+  bool inputHashKnown;
+
+  // With recording on, the rulebook getters append a precomputeRuleBooks plan
+  // row to recordedPlan for each cache entry they are first asked for
+  bool recording;
+  std::vector<long> recordedPlan;
+  std::unordered_set<const void *> recorded;
+
+  // The requests being built by lookahead, and the plan they point into
+  std::vector<long> lookaheadPlan;
+  std::vector<RuleBookRequest<dimension>> lookaheadRequests;
+  // Makes the getters safe to call from several threads (see RuleBookCache.h)
+  CacheGuard cacheGuard;
+  // Declared last, so that the thread is stopped before the caches go
+  LookaheadWorker lookahead;
 
   Metadata();
   void clear();
+  void setSortedRuleBooks(bool sorted);
   Int getNActive(/*long*/ at::Tensor spatialSize);
   SparseGrids<dimension> &getSparseGrid(/*long*/ at::Tensor spatialSize);
   void setInputSpatialSize(/*long*/ at::Tensor spatialSize);
@@ -86,9 +181,42 @@ public:
   void setInputSpatialLocations(/*float*/ at::Tensor features,
                                 /*long*/ at::Tensor locations,
                                 /*float*/ at::Tensor vecs, bool overwrite);
+  // Renumber the input sites in Morton order, permuting the rows of features
+  // (CPU floats, or empty) to match, and number the sites of the smaller
+  // scales in Morton order too. Call once all the input sites have been added;
+  // the rulebooks built so far, including those of the input/output layers,
+  // are dropped.
+  void mortonOrderInput(/*float*/ at::Tensor features);
 
   void getSpatialLocations(/*long*/ at::Tensor spatialSize,
                            /*long*/ at::Tensor locations);
+
+  // Hash of the input sites in row order, the input spatial size and the
+  // rulebook options; inputKey gives it in hex, to name the files written by
+  // saveRuleBooks
+  uint64_t inputHash();
+  std::string inputKey();
+  // inputHash, without waiting for lookahead, which does not change the input
+  // sites
+  uint64_t currentInputHash();
+  // Write nActive, the grids, the submanifold and strided convolution
+  // rulebooks and the input/output layer rulebooks to a file (see
+  // MetadataFile.h). False if the file could not be written.
+  bool saveRuleBooks(std::string filename);
+  // Replace them with those saved for the same input sites. The other caches
+  // are cleared. False, leaving the object unchanged, if the file is missing
+  // or does not match.
+  bool loadRuleBooks(std::string filename);
+  // The same, through a ByteTensor, e.g. to hand a Metadata object built in a
+  // DataLoader worker process over to the main process in shared memory:
+  // deserializeRuleBooks adopts everything, the input sites included. The
+  // rulebooks borrow their rules from bytes, without copying them, and keep it
+  // alive; the grids are copied into their hash tables.
+  void serializeRuleBooks(/*byte*/ at::Tensor bytes);
+  bool deserializeRuleBooks(/*byte*/ at::Tensor bytes);
+  void writeRuleBooks(MetadataFileWriter &w, uint64_t key);
+  // With adopt false, only reads the file if it is for the same input sites
+  bool readRuleBooks(MetadataFileReader &r, bool adopt);
   void createMetadataForDenseToSparse(/*long*/ at::Tensor spatialSize,
                                       /*long*/ at::Tensor nz_, long batchSize);
 
@@ -112,13 +240,50 @@ public:
   // 3x3 submanifold convolutions, 2x2 pooling or strided convolutions
   void generateRuleBooks2s2();
 
+  // Build the rulebooks listed in plan, one request per row:
+  //   kind, input spatial size, output spatial size, filter size, stride
+  // with kind a RuleBookKind (see sparseconvnet.rulebook_plan). Rulebooks for
+  // different scales are built in parallel once their input grids exist.
+  void precomputeRuleBooks(/*long*/ at::Tensor plan);
+  // The requests of plan, numbered from 0; creates their cache entries, and
+  // returns the number of waves
+  Int planRuleBooks(long *plan, Int nRows,
+                    std::vector<RuleBookRequest<dimension>> &requests);
+  void buildRuleBookRequest(RuleBookRequest<dimension> &r, bool openMP);
+
+  // Build the rulebooks listed in plan on a background thread, one at a time
+  // in the order of the plan, typically one recorded on the previous batch.
+  // The getters wait for the entries they need; the other functions that
+  // read or change the grids wait for the whole plan.
+  void startLookahead(/*long*/ at::Tensor plan);
+  void finishLookahead();
+  void recordRuleBooks(bool record);
+  void getRecordedPlan(/*long*/ at::Tensor plan);
+  void unpublishRuleBooks();
+  // The entry for key in cache, built by build(entry, input grids) unless it
+  // has been already (see RuleBookCache.h)
+  template <typename Cache, typename Build>
+  typename Cache::mapped_type &
+  getCached(Cache &cache, const typename Cache::key_type &key,
+            const Point<dimension> &inputSpatialSize, Build build);
+  // Set the output grid of a strided rulebook, and its nActive, to
+  // build(grids); exclusive holds the lock throughout
+  template <typename Build>
+  void buildOutputGrid(const Point<dimension> &outputSpatialSize,
+                       bool exclusive, Build build);
+  void record(Int kind, long *inputSpatialSize, long *outputSpatialSize,
+              long *size, long *stride, const void *entry);
+
   void inputLayer(/*long*/ at::Tensor spatialSize,
                   /*long*/ at::Tensor coords, Int batchSize, Int mode);
   void blLayer(/*long*/ at::Tensor spatialSize, /*long*/ at::Tensor coords,
                Int mode);
   RuleBook &getSubmanifoldRuleBook(/*long*/ at::Tensor spatialSize,
                                    /*long*/ at::Tensor size, bool openMP);
-  RuleBook &getActivePoolingRuleBook(/*long*/ at::Tensor spatialSize);
+  NeighbourTable &getSubmanifoldNeighbourTable(/*long*/ at::Tensor spatialSize,
+                                               /*long*/ at::Tensor size,
+                                               bool openMP);
+  TableRuleBook &getActivePoolingRuleBook(/*long*/ at::Tensor spatialSize);
   RuleBook &getSparseToDenseRuleBook(/*long*/ at::Tensor spatialSize,
                                      bool openMP);
   RuleBook &getRuleBook(/*long*/ at::Tensor inputSpatialSize,
@@ -131,6 +296,26 @@ public:
                                        /*long*/ at::Tensor stride,
                                        Metadata<dimension> &newM);
 
+  // The builders behind the get...RuleBook functions
+  void buildSubmanifoldRuleBook(RuleBook &rb, SparseGrids<dimension> &SGs,
+                                long *size, bool openMP);
+  // Build rb from the published neighbour table for key, or a published
+  // submanifold rulebook for the same spatial size and a larger or, failing
+  // that, a smaller filter size that leaves fewer offsets to look up than half
+  // the stencil; false if there is none.
+  bool deriveSubmanifoldRuleBook(RuleBook &rb, SparseGrids<dimension> &SGs,
+                                 const Point<2 * dimension> &key, bool openMP);
+  void buildSparseToDenseRuleBook(RuleBook &rb, SparseGrids<dimension> &SGs,
+                                  long *spatialSize, bool openMP);
+  Int buildRuleBook(RuleBook &rb, SparseGrids<dimension> &iSGs,
+                    SparseGrids<dimension> &oSGs, long *size, long *stride,
+                    long *inputSpatialSize, long *outputSpatialSize,
+                    bool openMP);
+  Int buildRandomizedStrideRuleBook(RuleBook &rb, SparseGrids<dimension> &iSGs,
+                                    SparseGrids<dimension> &oSGs, long *size,
+                                    long *stride, long *inputSpatialSize,
+                                    long *outputSpatialSize, bool openMP);
+
   RuleBook &getRandomizedStrideRuleBook(/*long*/ at::Tensor inputSpatialSize,
                                         /*long*/ at::Tensor outputSpatialSize,
                                         /*long*/ at::Tensor size,
@@ -0,0 +1,383 @@
+// Copyright 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef METADATAFILE_H
+#define METADATAFILE_H
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+// Binary files holding the grids and rulebooks of a Metadata object (see
+// Metadata::saveRuleBooks), so that repeated passes over the same inputs can
+// load them instead of building them again. The same format serves to pass
+// Metadata objects between processes in shared memory (see
+// Metadata::serializeRuleBooks).
+//
+// A file is a MetadataFileHeader followed by a sequence of fields, each padded
+// to a multiple of 8 bytes. Arrays are a uint64_t count followed by the
+// elements. Everything is stored in the byte order of the machine that wrote
+// the file, so the arrays are read straight out of a memory mapping of the
+// file; the version number must be bumped whenever the layout changes.
+
+const uint32_t metadataFileVersion = 2;
+
+struct MetadataFileHeader {
+  char magic[8];
+  uint32_t version, dimension, intSize, flags;
+  uint64_t key;
+};
+
+// Writes to a file, or to memory. With out == nullptr, the writer just counts
+// the bytes.
+class MetadataFileWriter {
+public:
+  std::FILE *f;
+  char *out;
+  std::size_t size;
+  bool ok;
+  MetadataFileWriter(const std::string &filename)
+      : f(std::fopen(filename.c_str(), "wb")), out(nullptr), size(0),
+        ok(f != nullptr) {}
+  MetadataFileWriter(char *out) : f(nullptr), out(out), size(0), ok(true) {}
+  ~MetadataFileWriter() { close(); }
+  void bytes(const void *p, std::size_t n) {
+    static const char padding[8] = {0};
+    std::size_t pad = (8 - n % 8) % 8;
+    if (f) {
+      if (ok and n)
+        ok = std::fwrite(p, 1, n, f) == n;
+      if (ok and pad)
+        ok = std::fwrite(padding, 1, pad, f) == pad;
+    } else if (out) {
+      if (n)
+        std::memcpy(out + size, p, n);
+      std::memcpy(out + size + n, padding, pad);
+    }
+    size += n + pad;
+  }
+  template <typename T> void value(const T &x) { bytes(&x, sizeof(T)); }
+  template <typename T> void array(const std::vector<T> &v) {
+    value<uint64_t>(v.size());
+    bytes(v.data(), v.size() * sizeof(T));
+  }
+  // False if anything failed to be written
+  bool close() {
+    if (f)
+      ok = std::fclose(f) == 0 and ok;
+    f = nullptr;
+    return ok;
+  }
+};
+
+// Reads a memory mapped file, or memory. Reads past the end, or of malformed
+// counts, clear ok and return zeros. When reading memory that owner keeps
+// alive, the rulebooks borrow their rules from it rather than copying them.
+class MetadataFileReader {
+public:
+  void *map;
+  std::size_t length;
+  const char *p, *end;
+  bool ok;
+  std::shared_ptr<void> owner;
+  MetadataFileReader(const std::string &filename)
+      : map(nullptr), length(0), p(nullptr), end(nullptr), ok(false) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+      return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 and st.st_size > 0) {
+      void *m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (m != MAP_FAILED) {
+        map = m;
+        length = st.st_size;
+        p = (const char *)m;
+        end = p + length;
+        ok = true;
+      }
+    }
+    ::close(fd);
+  }
+  MetadataFileReader(char *data, std::size_t n, std::shared_ptr<void> owner)
+      : map(nullptr), length(0), p(data), end(data + n), ok(data != nullptr),
+        owner(owner) {}
+  ~MetadataFileReader() {
+    if (map)
+      munmap(map, length);
+  }
+  std::size_t remaining() const { return end - p; }
+  // The next n bytes, or nullptr
+  const char *bytes(std::size_t n) {
+    std::size_t padded = n + (8 - n % 8) % 8;
+    if (not ok or n > remaining() or padded > remaining()) {
+      ok = false;
+      return nullptr;
+    }
+    const char *q = p;
+    p += padded;
+    return q;
+  }
+  template <typename T> T value() {
+    T x;
+    std::memset(&x, 0, sizeof(T));
+    const char *q = bytes(sizeof(T));
+    if (q)
+      std::memcpy(&x, q, sizeof(T));
+    return x;
+  }
+  // A count of items that take up at least itemBytes bytes each
+  uint64_t count(std::size_t itemBytes) {
+    uint64_t n = value<uint64_t>();
+    if (n > remaining() / itemBytes)
+      ok = false;
+    return ok ? n : 0;
+  }
+  template <typename T> void array(std::vector<T> &v) {
+    uint64_t n = count(sizeof(T));
+    const char *q = bytes(n * sizeof(T));
+    v.resize(q ? n : 0);
+    if (q and n)
+      std::memcpy(v.data(), q, n * sizeof(T));
+  }
+};
+
+inline void MetadataFile_write(MetadataFileWriter &w, Int x) { w.value(x); }
+inline void MetadataFile_read(MetadataFileReader &r, Int &x) {
+  x = r.value<Int>();
+}
+
+inline void MetadataFile_write(MetadataFileWriter &w, const RuleBook &rb) {
+  w.array(rb.offsets);
+  w.value<uint64_t>(2 * rb.nRules());
+  w.bytes(rb.data(), 2 * rb.nRules() * sizeof(Int));
+}
+inline void MetadataFile_read(MetadataFileReader &r, RuleBook &rb) {
+  rb.clear();
+  std::vector<Int> offsets;
+  r.array(offsets);
+  uint64_t n = r.count(sizeof(Int));
+  const char *q = r.bytes(n * sizeof(Int));
+  bool monotone = offsets.empty() or offsets[0] == 0;
+  for (std::size_t k = 1; monotone and k < offsets.size(); k++)
+    monotone = offsets[k] >= offsets[k - 1];
+  if (not q or offsets.size() == 1 or not monotone or
+      (not offsets.empty() and 2 * (uint64_t)offsets.back() != n)) {
+    r.ok = false;
+    return;
+  }
+  if (r.owner) {
+    // The memory is writable: it is only const to the reader
+    rb.borrow(offsets, (Int *)q, r.owner);
+  } else {
+    rb.offsets.swap(offsets);
+    rb.rules.resize(n);
+    if (n)
+      std::memcpy(rb.rules.data(), q, n * sizeof(Int));
+  }
+}
+
+// Whether rb has nOffsets filter offsets, input rows < nInputRows and output
+// rows < nOutputRows; the kernels index the feature and weight matrices with
+// them unchecked
+inline bool MetadataFile_check(const RuleBook &rb, Int nOffsets,
+                               Int nInputRows, Int nOutputRows) {
+  if (rb.size() != nOffsets)
+    return false;
+  // Negative rows become large unsigned ones
+  using UInt = std::make_unsigned<Int>::type;
+  const UInt *r = (const UInt *)rb.data();
+  long n = rb.nRules(), i;
+  UInt nIn = std::max(nInputRows, (Int)0), nOut = std::max(nOutputRows, (Int)0);
+  int bad = 0;
+#pragma omp parallel for reduction(| : bad) private(i)
+  for (i = 0; i < n; i++)
+    bad |= (r[2 * i] >= nIn) | (r[2 * i + 1] >= nOut);
+  return not bad;
+}
+
+inline void MetadataFile_write(MetadataFileWriter &w, const TableRuleBook &rb) {
+  w.value<uint64_t>(rb.size());
+  for (auto const &row : rb)
+    w.array(row);
+}
+inline void MetadataFile_read(MetadataFileReader &r, TableRuleBook &rb) {
+  rb.resize(r.count(8));
+  for (auto &row : rb)
+    r.array(row);
+}
+
+// Packed and direct tables are stored slot by slot, so they come back without
+// rehashing and iterate in the same order as when they were saved
+template <Int dimension>
+void MetadataFile_write(MetadataFileWriter &w,
+                        const SparseGridMap<dimension> &mp) {
+  w.value<uint64_t>(mp.direct ? 2 : mp.packed);
+  if (mp.direct) {
+    w.value(mp.directMap.box);
+    w.array(mp.directMap.cells);
+    w.array(mp.directMap.values);
+  } else if (mp.packed) {
+    w.array(mp.packedMap.keys);
+    w.array(mp.packedMap.values);
+  } else {
+    std::vector<Point<dimension>> points;
+    std::vector<Int> rows;
+    for (auto const &iter : mp) {
+      points.push_back(iter.first);
+      rows.push_back(iter.second);
+    }
+    w.array(points);
+    w.array(rows);
+  }
+}
+template <Int dimension>
+void MetadataFile_read(MetadataFileReader &r, SparseGridMap<dimension> &mp) {
+  uint64_t mode = r.value<uint64_t>();
+  mp.packed = mode == 1;
+  mp.direct = mode == 2;
+  mp.packedMap.clear();
+  mp.arrayMap.clear();
+  mp.directMap = DirectGridTable<dimension>();
+  mp.directThreshold = 0;
+  if (mp.direct) {
+    auto &d = mp.directMap;
+    d.reset(r.value<Point<dimension>>());
+    r.array(d.cells);
+    r.array(d.values);
+    if (not r.ok or d.slots.empty() or d.cells.size() != d.values.size()) {
+      r.ok = false;
+      mp.direct = false;
+      return;
+    }
+    for (std::size_t i = 0; i < d.cells.size(); i++) {
+      Int k = d.cells[i];
+      if (k < 0 or k >= (Int)d.slots.size() or d.slots[k] >= 0) {
+        r.ok = false;
+        mp.direct = false;
+        return;
+      }
+      d.slots[k] = i;
+    }
+  } else if (mp.packed) {
+    auto &t = mp.packedMap;
+    r.array(t.keys);
+    r.array(t.values);
+    std::size_t cap = t.keys.size();
+    t.nEntries = 0;
+    for (auto k : t.keys)
+      t.nEntries += k != packedEmptyKey;
+    // Capacity a power of two, and the load factor at most 1/2
+    if (not r.ok or cap == 0 or (cap & (cap - 1)) or t.values.size() != cap or
+        2 * t.nEntries > cap) {
+      r.ok = false;
+      t.clear();
+      return;
+    }
+    t.mask = cap - 1;
+  } else {
+    std::vector<Point<dimension>> points;
+    std::vector<Int> rows;
+    r.array(points);
+    r.array(rows);
+    if (points.size() != rows.size()) {
+      r.ok = false;
+      return;
+    }
+    for (std::size_t i = 0; i < points.size(); i++)
+      mp.arrayMap[points[i]] = rows[i];
+  }
+}
+
+// Whether the input/output layer rulebook rb (see IOLayersRules.h), empty or
+// with headerSize header entries, is well formed and has at most nActive
+// output rows
+inline bool MetadataFile_check(const TableRuleBook &rb, std::size_t headerSize,
+                               Int nActive) {
+  if (rb.empty())
+    return true;
+  if (rb[0].size() != headerSize or rb.size() != (rb[0][0] == 0 ? 1u : 2u))
+    return false;
+  auto const &h = rb[0];
+  long maxActive = h[1], nOutputRows = h.back();
+  long nInputRows = headerSize == 4 ? h[2] : (long)h[2] * h[3];
+  if (maxActive < 0 or nOutputRows < 0 or nOutputRows > nActive or
+      nInputRows < 0)
+    return false;
+  if (rb.size() == 1)
+    return true;
+  auto const &t = rb[1];
+  if ((long)t.size() != nOutputRows * (maxActive + 1))
+    return false;
+  for (std::size_t i = 0; i < t.size(); i += maxActive + 1) {
+    if (t[i] < 0)
+      return false;
+    for (long j = 1; j <= std::min((long)t[i], maxActive); j++)
+      if (t[i + j] < 0 or t[i + j] >= nInputRows)
+        return false;
+  }
+  return true;
+}
+
+template <Int dimension>
+void MetadataFile_write(MetadataFileWriter &w,
+                        const SparseGrids<dimension> &SGs) {
+  w.value<uint64_t>(SGs.size());
+  for (auto const &sg : SGs) {
+    w.value(sg.ctr);
+    MetadataFile_write(w, sg.mp);
+  }
+}
+template <Int dimension>
+void MetadataFile_read(MetadataFileReader &r, SparseGrids<dimension> &SGs) {
+  SGs.clear();
+  SGs.resize(r.count(16));
+  for (auto &sg : SGs) {
+    sg.ctr = r.value<Int>();
+    MetadataFile_read(r, sg.mp);
+  }
+}
+// Whether the sites of SGs have rows < nActive
+template <Int dimension>
+bool MetadataFile_check(const SparseGrids<dimension> &SGs, Int nActive) {
+  for (auto const &sg : SGs)
+    for (auto const &iter : sg.mp)
+      if (iter.second < 0 or sg.ctr < 0 or
+          (long)sg.ctr + iter.second >= nActive)
+        return false;
+  return true;
+}
+
+// The caches of Metadata, indexed by spatial size and filter parameters
+template <typename Key, typename T, typename Hash>
+void MetadataFile_write(MetadataFileWriter &w,
+                        const std::unordered_map<Key, T, Hash> &m) {
+  w.value<uint64_t>(m.size());
+  for (auto const &x : m) {
+    w.value(x.first);
+    MetadataFile_write(w, x.second);
+  }
+}
+template <typename Key, typename T, typename Hash>
+void MetadataFile_read(MetadataFileReader &r,
+                       std::unordered_map<Key, T, Hash> &m) {
+  m.clear();
+  uint64_t n = r.count(8);
+  for (uint64_t i = 0; r.ok and i < n; i++) {
+    Key k = r.value<Key>();
+    MetadataFile_read(r, m[k]);
+  }
+}
+
+#endif /* METADATAFILE_H */
@@ -0,0 +1,90 @@
+// Copyright 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef MORTONORDER_H
+#define MORTONORDER_H
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Renumbering of active sites in Morton (Z-) order, so that sites that are
+// close in space get nearby rows in the feature matrices and the rulebook
+// kernels gather and scatter runs of neighbouring rows.
+// Sample b gets a contiguous block of rows, starting after those of samples
+// 0, ..., b - 1.
+
+// Interleaved bits of p - lo, 64 / dimension bits per axis. Higher bits are
+// dropped; that only makes the order a little less local.
+template <Int dimension>
+uint64_t mortonCode(const Point<dimension> &p, const Point<dimension> &lo) {
+  uint64_t code = 0;
+  Int bits = 64 / dimension;
+  for (Int b = bits - 1; b >= 0; b--)
+    for (Int i = 0; i < dimension; i++)
+      code = (code << 1) | (((uint64_t)(p[i] - lo[i]) >> b) & 1);
+  return code;
+}
+
+// Renumber the active sites of SGs in Morton order, sample by sample.
+// newRow[r] is the new number of the site that was row r. The numbering
+// convention of the SparseGrids is kept: rows are mp values plus ctr.
+template <Int dimension>
+void MortonOrder_renumber(SparseGrids<dimension> &SGs, std::vector<Int> &newRow,
+                          Int nActive) {
+  newRow.resize(nActive);
+  Int row = 0;
+  for (auto &sg : SGs) {
+    if (sg.mp.size() == 0)
+      continue;
+    Point<dimension> lo = sg.mp.begin()->first;
+    for (auto const &iter : sg.mp)
+      for (Int i = 0; i < dimension; i++)
+        lo[i] = std::min(lo[i], iter.first[i]);
+    std::vector<std::pair<uint64_t, Int>> codes;
+    std::vector<Point<dimension>> points;
+    codes.reserve(sg.mp.size());
+    points.reserve(sg.mp.size());
+    for (auto const &iter : sg.mp) {
+      codes.push_back(std::make_pair(mortonCode<dimension>(iter.first, lo),
+                                     (Int)points.size()));
+      points.push_back(iter.first);
+    }
+    std::sort(codes.begin(), codes.end());
+    // Blocks of rows are contiguous from the first sample on, so ctr only
+    // changes if the rows of the samples were interleaved
+    Int ctr = sg.ctr;
+    if (ctr != row)
+      ctr = sg.ctr = 0;
+    for (auto const &c : codes) {
+      auto &v = sg.mp[points[c.second]];
+      newRow[v + ctr] = row;
+      v = row++ - ctr;
+    }
+  }
+}
+
+// Renumber the output rows of a rulebook
+inline void MortonOrder_renumberRules(RuleBook &rules,
+                                      const std::vector<Int> &newRow) {
+  Int n = rules.nRules();
+  Int *r = rules.data();
+  Int i;
+#pragma omp parallel for private(i)
+  for (i = 0; i < n; i++)
+    r[2 * i + 1] = newRow[r[2 * i + 1]];
+}
+
+// Renumber the active sites of SGs, which rules has just created
+template <Int dimension>
+void MortonOrder_renumberOutputs(SparseGrids<dimension> &SGs, RuleBook &rules,
+                                 Int nActive) {
+  std::vector<Int> newRow;
+  MortonOrder_renumber<dimension>(SGs, newRow, nActive);
+  MortonOrder_renumberRules(rules, newRow);
+}
+
+#endif /* MORTONORDER_H */
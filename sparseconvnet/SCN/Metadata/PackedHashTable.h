@@ -0,0 +1,110 @@
+// Copyright 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef PACKEDHASHTABLE_H
+#define PACKEDHASHTABLE_H
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Open addressing hash table from packed points (see SparseGridMap.h) to row
+// numbers, with linear probing and a maximum load factor of 1/2.
+// Keys and values are kept in separate arrays so that a probe sequence walks
+// through consecutive 8 byte keys; all ones marks an empty slot.
+// Slots are addressed by index; capacity() is the "end" slot.
+
+const uint64_t packedEmptyKey = ~(uint64_t)0;
+
+class PackedHashTable {
+public:
+  std::vector<uint64_t> keys;
+  std::vector<Int> values;
+  std::size_t nEntries;
+  std::size_t mask;
+
+  PackedHashTable() { clear(); }
+  std::size_t size() const { return nEntries; }
+  std::size_t capacity() const { return keys.size(); }
+  void clear() {
+    nEntries = 0;
+    keys.assign(32, packedEmptyKey);
+    values.assign(32, 0);
+    mask = 31;
+  }
+
+  std::size_t bucket(uint64_t k) const { return fmix64(k) & mask; }
+  // Slot holding k, or capacity()
+  std::size_t find(uint64_t k) const {
+    for (std::size_t i = bucket(k);; i = (i + 1) & mask) {
+      if (keys[i] == k)
+        return i;
+      if (keys[i] == packedEmptyKey)
+        return capacity();
+    }
+  }
+  // Slot holding k, inserting (k, v) first if k is absent
+  std::pair<std::size_t, bool> insert(uint64_t k, Int v) {
+    if (2 * (nEntries + 1) > capacity())
+      rehash(2 * capacity());
+    std::size_t i = bucket(k);
+    for (; keys[i] != packedEmptyKey; i = (i + 1) & mask)
+      if (keys[i] == k)
+        return std::make_pair(i, false);
+    keys[i] = k;
+    values[i] = v;
+    nEntries++;
+    return std::make_pair(i, true);
+  }
+  Int &operator[](uint64_t k) { return values[insert(k, 0).first]; }
+  // First occupied slot at or after slot i
+  std::size_t next(std::size_t i) const {
+    while (i < capacity() and keys[i] == packedEmptyKey)
+      i++;
+    return i;
+  }
+
+  // Batched lookup of the keys base + deltas[j], j < n: out[j] is the value
+  // stored under the key, or -1. The buckets are prefetched before any of them
+  // is probed, so the cache misses overlap.
+  void find(uint64_t base, const uint64_t *deltas, Int n, Int *out) const {
+#if defined(__GNUC__)
+    for (Int j = 0; j < n; j++)
+      __builtin_prefetch(&keys[bucket(base + deltas[j])]);
+#endif
+    for (Int j = 0; j < n; j++) {
+      std::size_t i = find(base + deltas[j]);
+      out[j] = i < capacity() ? values[i] : -1;
+    }
+  }
+
+  // Make room for n entries without further rehashing
+  void reserve(std::size_t n) {
+    std::size_t cap = capacity();
+    while (2 * n > cap)
+      cap *= 2;
+    if (cap > capacity())
+      rehash(cap);
+  }
+
+  void rehash(std::size_t n) {
+    std::vector<uint64_t> oldKeys(n, packedEmptyKey);
+    std::vector<Int> oldValues(n);
+    oldKeys.swap(keys);
+    oldValues.swap(values);
+    mask = n - 1;
+    for (std::size_t j = 0; j < oldKeys.size(); j++) {
+      if (oldKeys[j] == packedEmptyKey)
+        continue;
+      std::size_t i = bucket(oldKeys[j]);
+      while (keys[i] != packedEmptyKey)
+        i = (i + 1) & mask;
+      keys[i] = oldKeys[j];
+      values[i] = oldValues[j];
+    }
+  }
+};
+#endif /* PACKEDHASHTABLE_H */
@@ -73,17 +73,20 @@ RSROutputRegionCalculator(const Point<dimension> &input, RSRTicksV &t) {
   return RectangularRegion<dimension>(lb, ub);
 }
 
+// Two passes, as for Convolution_InputSgToRulesAndOutputSg
 template <Int dimension>
 void RSR_InputSgToRulesAndOutputSg(SparseGrid<dimension> &inputGrid,
                                    SparseGrid<dimension> &outputGrid,
                                    RuleBook &rules, RSRTicksV &t, long *size,
-                                   long *stride) {
-  rules.resize(volume<dimension>(size));
-
+                                   long *stride, bool fill) {
   for (auto const &inIter : inputGrid.mp) {
     for (auto j : RSROutputRegionCalculator<dimension>(inIter.first, t)) {
       auto inRegion = RSRInputRegionCalculator<dimension>(j, t);
       Int rulesOffset = inRegion.offset(inIter.first);
+      if (not fill) {
+        rules.count(rulesOffset);
+        continue;
+      }
       auto outIter = outputGrid.mp.find(j);
       if (outIter == outputGrid.mp.end()) {
         outIter =
@@ -91,8 +94,7 @@ void RSR_InputSgToRulesAndOutputSg(SparseGrid<dimension> &inputGrid,
       }
       assert(inIter.second < 1e6);
       assert(outIter->second < 1e6);
-      rules[rulesOffset].push_back(inIter.second + inputGrid.ctr);
-      rules[rulesOffset].push_back(outIter->second);
+      rules.add(rulesOffset, inIter.second + inputGrid.ctr, outIter->second);
     }
   }
 }
@@ -107,16 +109,21 @@ Int RSR_InputSgsToRulesAndOutputSgs(SparseGrids<dimension> &input_SGs,
   auto t = RSRRegions(input_spatialSize, output_spatialSize, dimension, size,
                       stride, re);
 
-  rules.clear();
   output_SGs.clear();
   Int batchSize = input_SGs.size();
   output_SGs.resize(batchSize);
+  rules.startCounting(volume<dimension>(size));
+  for (Int i = 0; i < batchSize; i++)
+    RSR_InputSgToRulesAndOutputSg<dimension>(input_SGs[i], output_SGs[i],
+                                             rules, t, size, stride, false);
+  rules.allocate();
   Int output_nActive = 0;
   for (Int i = 0; i < batchSize; i++) {
     auto &iSG = input_SGs[i];
     auto &oSG = output_SGs[i];
     oSG.ctr = output_nActive;
-    RSR_InputSgToRulesAndOutputSg<dimension>(iSG, oSG, rules, t, size, stride);
+    RSR_InputSgToRulesAndOutputSg<dimension>(iSG, oSG, rules, t, size, stride,
+                                             true);
     output_nActive = oSG.ctr;
     oSG.ctr = 0;
   }
@@ -132,8 +139,7 @@ Int RSR_InputSgsToRulesAndOutputSgs_OMP(SparseGrids<dimension> &input_SGs,
                                         std::default_random_engine re) {
   auto t = RSRRegions(input_spatialSize, output_spatialSize, dimension, size,
                       stride, re);
-  rules.clear();
-  rules.resize(volume<dimension>(size));
+  Int sd = volume<dimension>(size);
   output_SGs.clear();
   Int batchSize = input_SGs.size();
   output_SGs.resize(batchSize);
@@ -141,9 +147,14 @@ Int RSR_InputSgsToRulesAndOutputSgs_OMP(SparseGrids<dimension> &input_SGs,
   {
     Int i;
 #pragma omp parallel for private(i)
-    for (i = 0; i < batchSize; i++)
+    for (i = 0; i < batchSize; i++) {
+      rbs[i].startCounting(sd);
+      RSR_InputSgToRulesAndOutputSg<dimension>(input_SGs[i], output_SGs[i],
+                                               rbs[i], t, size, stride, false);
+      rbs[i].allocate();
       RSR_InputSgToRulesAndOutputSg<dimension>(input_SGs[i], output_SGs[i],
-                                               rbs[i], t, size, stride);
+                                               rbs[i], t, size, stride, true);
+    }
   }
   Int output_nActive = 0;
   for (Int i = 0; i < batchSize; i++) {
@@ -154,21 +165,8 @@ Int RSR_InputSgsToRulesAndOutputSgs_OMP(SparseGrids<dimension> &input_SGs,
     output_nActive += output_SGs[i].ctr;
     output_SGs[i].ctr = tmp;
   }
-  {
-    Int i;
-#pragma omp parallel for private(i)
-    for (i = 0; i < (Int)rules.size(); i++) {
-      auto &R = rules[i];
-      for (Int j = 0; j < batchSize; j++) {
-        auto &r = rbs[j][i];
-        auto offset = output_SGs[j].ctr;
-        for (Int k = 0; k < (Int)r.size();) {
-          R.push_back(r[k++]);
-          R.push_back(r[k++] + offset);
-        }
-      }
-    }
-  }
+  rules.concatenate(
+      rbs, sd, [&](Int j, Int r) { return r + output_SGs[j].ctr; }, true);
   return output_nActive;
 }
 #endif /* RSRRULES_H */
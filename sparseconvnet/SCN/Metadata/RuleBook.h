@@ -0,0 +1,153 @@
+// Copyright 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef RULEBOOK_H
+#define RULEBOOK_H
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+// Compact (CSR) rulebook.
+// The (input row, output row) pairs for all the filter offsets are stored back
+// to back in a single buffer; the pairs for filter offset k are
+//   rules[2 * offsets[k]] ... rules[2 * offsets[k + 1] - 1]
+//
+// Rulebooks are built in two passes so that the buffer is allocated exactly
+// once:
+//   rb.startCounting(filterVolume);
+//   ... rb.count(k) for each rule ...
+//   rb.allocate();
+//   ... rb.add(k, inputRow, outputRow) for each rule, in the same order ...
+//
+// A rulebook can also borrow its rules from memory that it does not own (see
+// borrow), e.g. a Metadata object handed over in shared memory.
+
+// Bytes allocated by rulebook copies and by the scratch space of the CPU
+// convolution kernels, since the extension was loaded
+inline std::atomic<long> &scratchBytes() {
+  static std::atomic<long> n(0);
+  return n;
+}
+
+class RuleBook {
+public:
+  std::vector<Int> offsets; // size() + 1 entries, measured in rules
+  std::vector<Int> rules;   // 2 * nRules() Ints, unless borrowed
+  std::vector<Int> cursor;  // Write positions during the fill pass
+  // The rules of a borrowed rulebook, and the owner of the memory they are in
+  Int *borrowed;
+  std::shared_ptr<void> owner;
+
+  RuleBook() : borrowed(nullptr) {}
+  RuleBook(const RuleBook &o)
+      : offsets(o.offsets), rules(o.rules), cursor(o.cursor),
+        borrowed(o.borrowed), owner(o.owner) {
+    countCopy();
+  }
+  RuleBook(RuleBook &&) = default;
+  RuleBook &operator=(const RuleBook &o) {
+    offsets = o.offsets;
+    rules = o.rules;
+    cursor = o.cursor;
+    borrowed = o.borrowed;
+    owner = o.owner;
+    countCopy();
+    return *this;
+  }
+  RuleBook &operator=(RuleBook &&) = default;
+
+  // Number of filter offsets
+  Int size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+  // An empty rulebook has not been built yet
+  bool empty() const { return offsets.empty(); }
+  void clear() {
+    offsets.clear();
+    rules.clear();
+    cursor.clear();
+    borrowed = nullptr;
+    owner.reset();
+  }
+  // Total number of rules, or the number of rules for filter offset k
+  Int nRules() const { return offsets.empty() ? 0 : offsets.back(); }
+  Int nRules(Int k) const { return offsets[k + 1] - offsets[k]; }
+  // All the rules, and the rules for filter offset k: nRules(k) (input,
+  // output) pairs
+  Int *data() { return borrowed ? borrowed : rules.data(); }
+  const Int *data() const { return borrowed ? borrowed : rules.data(); }
+  Int *operator[](Int k) { return data() + 2 * offsets[k]; }
+  const Int *operator[](Int k) const { return data() + 2 * offsets[k]; }
+
+  void startCounting(Int nOffsets) {
+    clear();
+    offsets.resize(nOffsets + 1, 0);
+  }
+  void count(Int k, Int n = 1) { offsets[k + 1] += n; }
+  void allocate() {
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    rules.resize(2 * offsets.back());
+    cursor.assign(offsets.begin(), offsets.end() - 1);
+  }
+  void add(Int k, Int input, Int output) {
+    Int *r = &rules[2 * cursor[k]++];
+    r[0] = input;
+    r[1] = output;
+  }
+  // Use the 2 * offsets.back() rules at r, which stay valid as long as owner
+  // is alive, without copying them
+  void borrow(std::vector<Int> offsets_, Int *r, std::shared_ptr<void> owner_) {
+    clear();
+    offsets.swap(offsets_);
+    borrowed = r;
+    owner = owner_;
+  }
+
+  // Build the rulebook out of parts (per sample or per chunk rulebooks): for
+  // each filter offset, the rules of parts[0] come first, then those of
+  // parts[1], and so on. Output row r of parts[j] becomes outputRow(j, r).
+  // Every (offset, part) block of rules is copied straight to its final
+  // position, in parallel if openMP.
+  template <typename F>
+  void concatenate(const std::vector<RuleBook> &parts, Int nOffsets,
+                   F outputRow, bool openMP) {
+    Int nParts = parts.size();
+    // start[k * nParts + j]: position of the rules of parts[j] for offset k
+    // among the rules for offset k
+    std::vector<Int> start((long)nOffsets * nParts);
+    startCounting(nOffsets);
+    Int k;
+#pragma omp parallel for private(k) if (openMP)
+    for (k = 0; k < nOffsets; k++) {
+      Int n = 0;
+      for (Int j = 0; j < nParts; j++) {
+        start[(long)k * nParts + j] = n;
+        n += parts[j].nRules(k);
+      }
+      offsets[k + 1] = n;
+    }
+    allocate();
+    long t;
+#pragma omp parallel for schedule(dynamic, 16) private(t) if (openMP)
+    for (t = 0; t < (long)nOffsets * nParts; t++) {
+      Int j = t % nParts;
+      Int n = parts[j].nRules(t / nParts);
+      const Int *r = parts[j][t / nParts];
+      Int *R = (*this)[t / nParts] + 2 * start[t];
+      for (Int i = 0; i < n; i++) {
+        R[2 * i] = r[2 * i];
+        R[2 * i + 1] = outputRow(j, r[2 * i + 1]);
+      }
+    }
+  }
+
+private:
+  void countCopy() {
+    scratchBytes() +=
+        sizeof(Int) * (offsets.size() + rules.size() + cursor.size());
+  }
+};
+
+#endif /* RULEBOOK_H */
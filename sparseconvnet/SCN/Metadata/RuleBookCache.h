@@ -0,0 +1,131 @@
+// Copyright 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef RULEBOOKCACHE_H
+#define RULEBOOKCACHE_H
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Lets several threads, e.g. running different branches of a network, use the
+// rulebook getters of one Metadata at once. The maps of Metadata are only
+// changed with CacheGuard::mutex held, and each entry is built by one thread
+// while the others wait for it. Functions that add input sites, or clear or
+// load the caches, must not run concurrently with anything else.
+
+// A rulebook cache. Built entries are published in an immutable index, which
+// the getters read without locking; publishing an entry replaces the index.
+// The versions it replaces are freed by the next publish that finds no
+// thread reading the index.
+template <typename Key, typename T, typename Hash>
+class RuleBookCache : public std::unordered_map<Key, T, Hash> {
+public:
+  using Map = std::unordered_map<Key, T, Hash>;
+  using Index = std::unordered_map<Key, T *, Hash>;
+  RuleBookCache() : index(nullptr), readers(0) {}
+  // Copies start with nothing published
+  RuleBookCache(const RuleBookCache &c) : Map(c), index(nullptr), readers(0) {}
+  RuleBookCache &operator=(const RuleBookCache &c) {
+    unpublish();
+    Map::operator=(c);
+    return *this;
+  }
+  // The entry for key if it has been published, or nullptr
+  T *published(const Key &key) const {
+    Reader r(*this);
+    if (not r.i)
+      return nullptr;
+    auto it = r.i->find(key);
+    return it == r.i->end() ? nullptr : it->second;
+  }
+  // Calls f(key, entry) for each published entry
+  template <typename F> void forEachPublished(F f) const {
+    Reader r(*this);
+    if (r.i)
+      for (auto &e : *r.i)
+        f(e.first, *e.second);
+  }
+  // With the mutex held
+  void publish(const Key &key, T *entry) {
+    const Index *i = index.load(std::memory_order_relaxed);
+    std::unique_ptr<Index> next(i ? new Index(*i) : new Index());
+    (*next)[key] = entry;
+    index.store(next.get());
+    if (current)
+      retired.push_back(std::move(current));
+    current = std::move(next);
+    // Readers that start from now on see next, so once there are none the
+    // older versions can go
+    if (readers.load() == 0)
+      retired.clear();
+  }
+  void unpublish() {
+    index.store(nullptr, std::memory_order_release);
+    retired.clear();
+    current.reset();
+  }
+  void clear() {
+    unpublish();
+    Map::clear();
+  }
+
+private:
+  // Counts a thread reading the index from before it loads the index until
+  // it is done with it
+  class Reader {
+  public:
+    const RuleBookCache &c;
+    const Index *i;
+    Reader(const RuleBookCache &c) : c(c) {
+      c.readers.fetch_add(1);
+      i = c.index.load();
+    }
+    ~Reader() { c.readers.fetch_sub(1); }
+  };
+  std::atomic<const Index *> index;
+  mutable std::atomic<long> readers;
+  // The published index, and older versions that threads may still be reading
+  std::unique_ptr<Index> current;
+  std::vector<std::unique_ptr<Index>> retired;
+};
+
+class CacheGuard {
+public:
+  std::mutex mutex;
+  std::condition_variable built;
+  // Entries being built, and grids being written
+  std::unordered_set<const void *> building;
+  CacheGuard() {}
+  // Copies do not share the lock
+  CacheGuard(const CacheGuard &) {}
+  CacheGuard &operator=(const CacheGuard &) { return *this; }
+  // With the mutex held through lock: wait until no thread is building p
+  void wait(std::unique_lock<std::mutex> &lock, const void *p) {
+    while (building.count(p))
+      built.wait(lock);
+  }
+  // With the mutex held through lock: true if entry is empty, in which case
+  // the caller is to build it and then release it
+  template <typename T>
+  bool claim(std::unique_lock<std::mutex> &lock, T &entry) {
+    wait(lock, &entry);
+    if (not entry.empty())
+      return false;
+    building.insert(&entry);
+    return true;
+  }
+  // With the mutex held
+  void release(const void *p) {
+    building.erase(p);
+    built.notify_all();
+  }
+};
+
+#endif /* RULEBOOKCACHE_H */
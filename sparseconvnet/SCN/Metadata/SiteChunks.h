@@ -0,0 +1,37 @@
+// Copyright 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef SITECHUNKS_H
+#define SITECHUNKS_H
+#include <algorithm>
+#include <vector>
+
+// Work items for the _OMP rule generators. The active sites of each sample are
+// cut into chunks of about ruleChunkSites sites, so that a single large sample
+// keeps all the threads busy. Each chunk gets rules of its own, and these are
+// concatenated in chunk order, which is the order in which the serial
+// generators visit the sites: the rulebooks come out the same.
+const Int ruleChunkSites = 4096;
+
+template <Int dimension> class SiteChunk {
+public:
+  Int sample;
+  typename SparseGridMap<dimension>::iterator begin, end;
+};
+
+template <Int dimension>
+std::vector<SiteChunk<dimension>> SiteChunks(SparseGrids<dimension> &SGs) {
+  std::vector<SiteChunk<dimension>> chunks;
+  for (Int i = 0; i < (Int)SGs.size(); i++) {
+    Int n = (SGs[i].mp.size() + ruleChunkSites - 1) / ruleChunkSites;
+    auto bounds = SGs[i].mp.split(std::max(n, 1));
+    for (Int j = 0; j + 1 < (Int)bounds.size(); j++)
+      chunks.push_back(SiteChunk<dimension>{i, bounds[j], bounds[j + 1]});
+  }
+  return chunks;
+}
+
+#endif /* SITECHUNKS_H */
@@ -0,0 +1,299 @@
+// Copyright 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef SORTEDRULES_H
+#define SORTEDRULES_H
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Sort-based rule generation, an alternative to looking every neighbour up in
+// the hash tables (see Metadata::setSortedRuleBooks).
+//
+// The active sites of a sample are sorted once by a packed key that orders
+// them lexicographically. Translating all the sites by the same filter offset
+// keeps them in that order, so the rules for an offset are found by merging
+// the translated list with the sorted list of candidate partners: the memory
+// accesses are sequential and nothing is hashed. (A Z-order key would not do:
+// translations do not preserve Z-order, so each offset would need a re-sort.)
+
+// Packs the points of the box [lo, hi] into int64_t keys that sort in
+// lexicographic order, with key(p + o) == key(p) + delta(o) whenever p and
+// p + o are both in the box. fits is false if the box needs more than 63 bits.
+template <Int dimension> class SortedRulesKeys {
+public:
+  Point<dimension> lo;
+  Int shift[dimension], width[dimension];
+  bool fits;
+  SortedRulesKeys(const Point<dimension> &lo, const Point<dimension> &hi)
+      : lo(lo) {
+    Int bits = 0;
+    for (Int i = dimension - 1; i >= 0; i--) {
+      uint64_t range = (uint64_t)((int64_t)hi[i] - lo[i]);
+      width[i] = 0;
+      while (width[i] < 63 and (range >> width[i]))
+        width[i]++;
+      shift[i] = bits;
+      bits += width[i];
+    }
+    fits = bits <= 63;
+  }
+  int64_t key(const Point<dimension> &p) const {
+    int64_t k = 0;
+    for (Int i = 0; i < dimension; i++)
+      k += ((int64_t)p[i] - lo[i]) << shift[i];
+    return k;
+  }
+  int64_t delta(const Point<dimension> &o) const {
+    int64_t d = 0;
+    for (Int i = 0; i < dimension; i++)
+      d += (int64_t)o[i] * ((int64_t)1 << shift[i]);
+    return d;
+  }
+  Point<dimension> point(int64_t k) const {
+    Point<dimension> p;
+    for (Int i = 0; i < dimension; i++)
+      p[i] = lo[i] + ((k >> shift[i]) & (((int64_t)1 << width[i]) - 1));
+    return p;
+  }
+};
+
+// (key, row) pairs, sorted by key
+using SortedSites = std::vector<std::pair<int64_t, Int>>;
+
+template <Int dimension>
+void SortedRules_sort(SparseGrid<dimension> &grid,
+                      const SortedRulesKeys<dimension> &keys,
+                      SortedSites &sites) {
+  sites.clear();
+  sites.reserve(grid.mp.size());
+  for (auto const &iter : grid.mp)
+    sites.push_back(std::make_pair(keys.key(iter.first), iter.second));
+  std::sort(sites.begin(), sites.end());
+}
+
+// Bounding box of the active sites; false if there are none
+template <Int dimension>
+bool SortedRules_bounds(SparseGrid<dimension> &grid, Point<dimension> &lo,
+                        Point<dimension> &hi) {
+  if (grid.mp.size() == 0)
+    return false;
+  lo = hi = grid.mp.begin()->first;
+  for (auto const &iter : grid.mp)
+    for (Int i = 0; i < dimension; i++) {
+      lo[i] = std::min(lo[i], iter.first[i]);
+      hi[i] = std::max(hi[i], iter.first[i]);
+    }
+  return true;
+}
+
+// Merge join: f(a row, b row) for each pair with a key == b key + delta
+template <typename F>
+void SortedRules_join(const SortedSites &a, const SortedSites &b,
+                      int64_t delta, F f) {
+  auto i = a.begin();
+  for (auto const &j : b) {
+    int64_t k = j.first + delta;
+    while (i != a.end() and i->first < k)
+      ++i;
+    if (i == a.end())
+      return;
+    if (i->first == k)
+      f(i->second, j.second);
+  }
+}
+
+// Merge join of the sites with themselves for a run of n filter offsets
+// along the last axis, starting at delta: f(m, input row, output row) for
+// each input at offset m of the run from an output. The last axis occupies
+// the low bits of the keys, so the whole run is one merge.
+template <typename F>
+void SortedRules_joinRun(const SortedSites &sites, int64_t delta, Int n, F f) {
+  auto i = sites.begin();
+  for (auto const &out : sites) {
+    int64_t k = out.first + delta;
+    while (i != sites.end() and i->first < k)
+      ++i;
+    for (auto j = i; j != sites.end() and j->first < k + n; ++j)
+      f((Int)(j->first - k), j->second, out.second);
+  }
+}
+
+// Same rules as SubmanifoldConvolution_SgToRules, built into a rulebook of
+// their own
+template <Int dimension>
+double SubmanifoldConvolution_SgToRules_Sorted(SparseGrid<dimension> &grid,
+                                               RuleBook &rules, long *size) {
+  Point<dimension> origin, lo, hi;
+  origin.fill(0);
+  SparseGridStencil<dimension> stencil(
+      InputRegionCalculator_Valid<dimension>(origin, size));
+  rules.startCounting(stencil.size());
+  if (not SortedRules_bounds<dimension>(grid, lo, hi)) {
+    rules.allocate();
+    return 0;
+  }
+  for (Int i = 0; i < dimension; i++) {
+    lo[i] += stencil.lo[i];
+    hi[i] += stencil.hi[i];
+  }
+  SortedRulesKeys<dimension> keys(lo, hi);
+  if (not keys.fits) {
+    std::vector<Int> found;
+    double countActiveInputs =
+        SubmanifoldConvolution_SgToRules<dimension>(grid, rules, size, found);
+    rules.allocate();
+    SubmanifoldConvolution_AddRules(rules, found);
+    return countActiveInputs;
+  }
+  SortedSites sites;
+  SortedRules_sort<dimension>(grid, keys, sites);
+  // The stencil is made of runs of size[dimension - 1] offsets along the last
+  // axis
+  Int n = size[dimension - 1];
+  for (Int k = 0; k < stencil.size(); k += n)
+    SortedRules_joinRun(sites, keys.delta(stencil.offsets[k]), n,
+                        [&](Int m, Int, Int) { rules.count(k + m); });
+  rules.allocate();
+  Int ctr = grid.ctr;
+  for (Int k = 0; k < stencil.size(); k += n)
+    SortedRules_joinRun(sites, keys.delta(stencil.offsets[k]), n,
+                        [&](Int m, Int in, Int out) {
+                          rules.add(k + m, in + ctr, out + ctr);
+                        });
+  return rules.nRules();
+}
+
+// Same rules as Convolution_InputSgToRulesAndOutputSg, built into a rulebook
+// of their own. The output sites are numbered from outputGrid.ctr in
+// lexicographic order.
+template <Int dimension>
+void Convolution_InputSgToRulesAndOutputSg_Sorted(
+    SparseGrid<dimension> &inputGrid, SparseGrid<dimension> &outputGrid,
+    RuleBook &rules, long *size, long *stride, long *inputSpatialSize,
+    long *outputSpatialSize) {
+  Int sd = volume<dimension>(size);
+  rules.startCounting(sd);
+  Point<dimension> inLo, inHi, outLo, outHi;
+  if (not SortedRules_bounds<dimension>(inputGrid, inLo, inHi)) {
+    rules.allocate();
+    return;
+  }
+  for (Int i = 0; i < dimension; i++) {
+    outLo[i] = std::max(0L, (inLo[i] - size[i] + stride[i]) / stride[i]);
+    outHi[i] = std::min(outputSpatialSize[i] - 1, inHi[i] / stride[i]);
+    if (outHi[i] < outLo[i]) {
+      rules.allocate();
+      return;
+    }
+  }
+  SortedRulesKeys<dimension> inKeys(inLo, inHi), outKeys(outLo, outHi);
+  if (not inKeys.fits or not outKeys.fits) {
+    Convolution_InputSgToRulesAndOutputSg<dimension>(
+        inputGrid, outputGrid, rules, size, stride, inputSpatialSize,
+        outputSpatialSize, false);
+    rules.allocate();
+    Convolution_InputSgToRulesAndOutputSg<dimension>(
+        inputGrid, outputGrid, rules, size, stride, inputSpatialSize,
+        outputSpatialSize, true);
+    return;
+  }
+  SortedSites inputs;
+  SortedRules_sort<dimension>(inputGrid, inKeys, inputs);
+  // For each filter offset, the (output key, input row) pairs in the order of
+  // the inputs, which is also the order of the output keys
+  std::vector<SortedSites> candidates(sd);
+  std::vector<int64_t> outputs;
+  for (auto const &in : inputs) {
+    auto p = inKeys.point(in.first);
+    auto outRegion =
+        OutputRegionCalculator<dimension>(p, size, stride, outputSpatialSize);
+    for (auto j : outRegion) {
+      auto inRegion = InputRegionCalculator<dimension>(j, size, stride);
+      int64_t outKey = outKeys.key(j);
+      candidates[inRegion.offset(p)].push_back(
+          std::make_pair(outKey, in.second));
+      outputs.push_back(outKey);
+    }
+  }
+  std::sort(outputs.begin(), outputs.end());
+  outputs.erase(std::unique(outputs.begin(), outputs.end()), outputs.end());
+  SortedSites outputRows(outputs.size());
+  for (Int i = 0; i < (Int)outputs.size(); i++) {
+    outputRows[i] = std::make_pair(outputs[i], outputGrid.ctr + i);
+    outputGrid.mp.insert(
+        std::make_pair(outKeys.point(outputs[i]), outputGrid.ctr + i));
+  }
+  outputGrid.ctr += outputs.size();
+  for (Int k = 0; k < sd; k++)
+    rules.count(k, candidates[k].size());
+  rules.allocate();
+  Int ctr = inputGrid.ctr;
+  for (Int k = 0; k < sd; k++)
+    SortedRules_join(outputRows, candidates[k], 0, [&](Int out, Int in) {
+      rules.add(k, in + ctr, out);
+    });
+}
+
+// The sorted counterparts of SubmanifoldConvolution_SgsToRules(_OMP) and
+// Convolution_InputSgsToRulesAndOutputSgs(_OMP); with openMP the samples are
+// processed in parallel.
+template <Int dimension>
+Int SubmanifoldConvolution_SgsToRules_Sorted(SparseGrids<dimension> &SGs,
+                                             RuleBook &rules, long *size,
+                                             bool openMP) {
+  std::vector<RuleBook> rbs(SGs.size());
+  std::vector<double> countActiveInputs(SGs.size());
+  Int sd = volume<dimension>(size);
+  {
+    Int i;
+#pragma omp parallel for private(i) if (openMP)
+    for (i = 0; i < (Int)SGs.size(); i++)
+      countActiveInputs[i] =
+          SubmanifoldConvolution_SgToRules_Sorted<dimension>(SGs[i], rbs[i],
+                                                             size);
+  }
+  rules.concatenate(rbs, sd, [](Int, Int r) { return r; }, openMP);
+  Int countActiveInputs_ = 0;
+  for (auto &i : countActiveInputs)
+    countActiveInputs_ += i;
+  return countActiveInputs_;
+}
+
+template <Int dimension>
+Int Convolution_InputSgsToRulesAndOutputSgs_Sorted(
+    SparseGrids<dimension> &input_SGs, SparseGrids<dimension> &output_SGs,
+    RuleBook &rules, long *filterSize, long *filterStride,
+    long *input_spatialSize, long *output_spatialSize, bool openMP) {
+  Int sd = volume<dimension>(filterSize);
+  output_SGs.clear();
+  Int batchSize = input_SGs.size();
+  output_SGs.resize(batchSize);
+  std::vector<RuleBook> rbs(batchSize);
+  {
+    Int i;
+#pragma omp parallel for private(i) if (openMP)
+    for (i = 0; i < batchSize; i++)
+      Convolution_InputSgToRulesAndOutputSg_Sorted<dimension>(
+          input_SGs[i], output_SGs[i], rbs[i], filterSize, filterStride,
+          input_spatialSize, output_spatialSize);
+  }
+  Int output_nActive = 0;
+  for (Int i = 0; i < batchSize; i++) {
+    // Parallel assignment:
+    // output_nActive     <-  output_nActive+output_SGs[i].ctr
+    // output_SGs[i].ctr  <-  output_nActive
+    Int tmp = output_nActive;
+    output_nActive += output_SGs[i].ctr;
+    output_SGs[i].ctr = tmp;
+  }
+  rules.concatenate(
+      rbs, sd, [&](Int j, Int r) { return r + output_SGs[j].ctr; }, openMP);
+  return output_nActive;
+}
+
+#endif /* SORTEDRULES_H */
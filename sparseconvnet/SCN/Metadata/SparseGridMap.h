@@ -0,0 +1,330 @@
+// Copyright 2016-present, Facebook, Inc.
+// All rights reserved.
+//
+// This source code is licensed under the license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef SPARSEGRIDMAP_H
+#define SPARSEGRIDMAP_H
+#include "DirectGridTable.h"
+#include "PackedHashTable.h"
+#include <algorithm>
+#include <google/dense_hash_map>
+#include <utility>
+#include <vector>
+
+// Hash table from the active points of a sparse grid to their row numbers.
+//
+// The key layout is chosen once, by setSpatialSize, when the grid is created.
+// If every coordinate of the spatial size fits in packedBits bits (21 bits per
+// axis in 3D) the points are packed into a single uint64_t key and stored in a
+// PackedHashTable: hashing and key comparisons are single word operations, and
+// whole stencils of neighbours can be looked up in one batch. Otherwise, and
+// until the spatial size is set, they are stored in a dense_hash_map with
+// Point<dimension> keys. Maps of grids with a small spatial size switch to
+// indexing their points directly once they are dense enough. Either way it
+// behaves like a dense_hash_map<Point<dimension>, Int>, except that iterators
+// give read-only copies of the (point, row) pairs; use operator[] to modify
+// the table.
+//
+// Hash is the hashing policy for the Point<dimension> keys.
+
+template <Int dimension> class SparseGridStencil;
+
+template <Int dimension, typename Hash = IntArrayMixHash<dimension>>
+class SparseGridMap {
+public:
+  using ArrayMap = google::dense_hash_map<Point<dimension>, Int, Hash,
+                                          std::equal_to<Point<dimension>>>;
+  // 63 / dimension bits per axis keeps the top bit clear, so the all-ones
+  // word is free to be the empty key.
+  static const Int packedBits = 63 / dimension;
+
+  bool packed, direct;
+  PackedHashTable packedMap;
+  ArrayMap arrayMap;
+  DirectGridTable<dimension> directMap;
+  // Size at which to switch to directMap, or 0
+  std::size_t directThreshold;
+
+  struct value_type {
+    Point<dimension> first;
+    Int second;
+  };
+
+  class iterator {
+  public:
+    const PackedHashTable *t;
+    bool packed;
+    std::size_t p;
+    typename ArrayMap::const_iterator a;
+    // Set for direct maps, whose slots p are numbered from 0
+    const DirectGridTable<dimension> *d;
+    mutable value_type v;
+    iterator(const PackedHashTable *t, bool packed, std::size_t p,
+             typename ArrayMap::const_iterator a,
+             const DirectGridTable<dimension> *d = nullptr)
+        : t(t), packed(packed), p(p), a(a), d(d) {}
+    const value_type &operator*() const {
+      if (d) {
+        v.first = d->point(d->cells[p]);
+        v.second = d->values[p];
+      } else if (packed) {
+        v.first = unpack(t->keys[p]);
+        v.second = t->values[p];
+      } else {
+        v.first = a->first;
+        v.second = a->second;
+      }
+      return v;
+    }
+    const value_type *operator->() const { return &**this; }
+    iterator &operator++() {
+      if (d)
+        p++;
+      else if (packed)
+        p = t->next(p + 1);
+      else
+        ++a;
+      return *this;
+    }
+    bool operator==(const iterator &o) const {
+      return d or packed ? p == o.p : a == o.a;
+    }
+    bool operator!=(const iterator &o) const { return not(*this == o); }
+  };
+
+  SparseGridMap() : packed(false), direct(false), directThreshold(0) {
+    // Sparsehash needs a key to be set aside and never used - we use
+    // (-1,...,-1)
+    Point<dimension> empty_key;
+    for (Int i = 0; i < dimension; ++i)
+      empty_key[i] = -1;
+    arrayMap.set_empty_key(empty_key);
+  }
+
+  static bool fits(const Point<dimension> &p) {
+    for (Int i = 0; i < dimension; i++)
+      if (p[i] < 0 or ((uint64_t)p[i] >> packedBits))
+        return false;
+    return true;
+  }
+  static uint64_t pack(const Point<dimension> &p) {
+    uint64_t k = 0;
+    for (Int i = 0; i < dimension; i++)
+      k |= (uint64_t)p[i] << (i * packedBits);
+    return k;
+  }
+  static Point<dimension> unpack(uint64_t k) {
+    Point<dimension> p;
+    for (Int i = 0; i < dimension; i++)
+      p[i] = (k >> (i * packedBits)) & ((1ULL << packedBits) - 1);
+    return p;
+  }
+
+  // Pick the key layout of an empty map for the points of [0, spatialSize),
+  // which is all zeros if unknown. If the box has at most directGridMaxVolume
+  // points, index them directly once the map holds 1 / directGridMinDensity of
+  // them; a sparser map is cheaper to hash than to give a slot array.
+  void setSpatialSize(const Point<dimension> &spatialSize) {
+    Point<dimension> last;
+    for (Int i = 0; i < dimension; i++)
+      last[i] = spatialSize[i] - 1;
+    packed = fits(last);
+    long v = DirectGridTable<dimension>::volume(spatialSize);
+    if (not v)
+      return;
+    directMap.box = spatialSize;
+    directThreshold = std::max(1L, v / directGridMinDensity);
+  }
+
+  std::size_t size() const {
+    if (direct)
+      return directMap.size();
+    return packed ? packedMap.size() : arrayMap.size();
+  }
+  iterator begin() const {
+    if (direct)
+      return iterator(&packedMap, false, 0, arrayMap.end(), &directMap);
+    if (packed)
+      return iterator(&packedMap, true, packedMap.next(0), arrayMap.end());
+    return iterator(&packedMap, false, 0, arrayMap.begin());
+  }
+  iterator end() const {
+    if (direct)
+      return iterator(&packedMap, false, directMap.size(), arrayMap.end(),
+                      &directMap);
+    return iterator(&packedMap, packed, packedMap.capacity(), arrayMap.end());
+  }
+  iterator find(const Point<dimension> &p) const {
+    if (direct)
+      return iterator(&packedMap, false, directMap.find(p), arrayMap.end(),
+                      &directMap);
+    if (not packed)
+      return iterator(&packedMap, false, 0, arrayMap.find(p));
+    if (not fits(p))
+      return end();
+    return iterator(&packedMap, true, packedMap.find(pack(p)), arrayMap.end());
+  }
+  // rows[j] = row of the active site p + stencil.offsets[j], or -1
+  void findNeighbours(const Point<dimension> &p,
+                      const SparseGridStencil<dimension> &stencil,
+                      Int *rows) const {
+    if (direct) {
+      for (Int j = 0; j < stencil.size(); j++) {
+        Point<dimension> q;
+        for (Int i = 0; i < dimension; i++)
+          q[i] = p[i] + stencil.offsets[j][i];
+        rows[j] = directMap.row(q);
+      }
+      return;
+    }
+    bool inside = packed;
+    for (Int i = 0; inside and i < dimension; i++)
+      inside = p[i] + stencil.lo[i] >= 0 and
+               not((uint64_t)(p[i] + stencil.hi[i]) >> packedBits);
+    if (inside) {
+      // Every neighbour packs, and packing commutes with adding offsets
+      packedMap.find(pack(p), &stencil.deltas[0], stencil.size(), rows);
+      return;
+    }
+    for (Int j = 0; j < stencil.size(); j++) {
+      Point<dimension> q;
+      for (Int i = 0; i < dimension; i++)
+        q[i] = p[i] + stencil.offsets[j][i];
+      auto iter = find(q);
+      rows[j] = iter == end() ? -1 : iter->second;
+    }
+  }
+  // nParts + 1 iterators cutting the table into nParts consecutive ranges of
+  // similar size
+  std::vector<iterator> split(Int nParts) const {
+    std::vector<iterator> bounds;
+    if (direct) {
+      for (Int j = 0; j < nParts; j++)
+        bounds.push_back(iterator(&packedMap, false, size() * j / nParts,
+                                  arrayMap.end(), &directMap));
+    } else if (packed) {
+      for (Int j = 0; j < nParts; j++)
+        bounds.push_back(iterator(
+            &packedMap, true, packedMap.next(packedMap.capacity() * j / nParts),
+            arrayMap.end()));
+    } else {
+      std::size_t n = 0;
+      for (auto a = arrayMap.begin(); a != arrayMap.end(); ++a, ++n)
+        while ((Int)bounds.size() < nParts and
+               n == size() * bounds.size() / nParts)
+          bounds.push_back(iterator(&packedMap, false, 0, a));
+    }
+    while ((Int)bounds.size() <= nParts)
+      bounds.push_back(end());
+    return bounds;
+  }
+  std::pair<iterator, bool> insert(const std::pair<Point<dimension>, Int> &x) {
+    if (directThreshold and size() >= directThreshold)
+      makeDirect();
+    if (direct and not directMap.inside(x.first))
+      undirect();
+    if (direct) {
+      auto r = directMap.insert(x.first, x.second);
+      return std::make_pair(
+          iterator(&packedMap, false, r.first, arrayMap.end(), &directMap),
+          r.second);
+    }
+    // Only a point outside the spatial size can fail to pack
+    if (packed and not fits(x.first))
+      unpackKeys();
+    if (packed) {
+      auto r = packedMap.insert(pack(x.first), x.second);
+      return std::make_pair(iterator(&packedMap, true, r.first, arrayMap.end()),
+                            r.second);
+    }
+    auto r = arrayMap.insert(x);
+    return std::make_pair(iterator(&packedMap, false, 0, r.first), r.second);
+  }
+  Int &operator[](const Point<dimension> &p) {
+    if (directThreshold and size() >= directThreshold)
+      makeDirect();
+    if (direct and not directMap.inside(p))
+      undirect();
+    if (direct)
+      return directMap.values[directMap.insert(p, 0).first];
+    if (packed and not fits(p))
+      unpackKeys();
+    return packed ? packedMap[pack(p)] : arrayMap[p];
+  }
+  void reserve(std::size_t n) {
+    if (direct)
+      directMap.reserve(n);
+    else if (packed)
+      packedMap.reserve(n);
+    else
+      arrayMap.resize(n);
+  }
+
+  // Move the entries over to Point<dimension> keys
+  void unpackKeys() {
+    for (std::size_t i = packedMap.next(0); i < packedMap.capacity();
+         i = packedMap.next(i + 1))
+      arrayMap[unpack(packedMap.keys[i])] = packedMap.values[i];
+    packedMap.clear();
+    packed = false;
+  }
+  // Move the entries over to directMap, unless some are outside its box
+  void makeDirect() {
+    directThreshold = 0;
+    std::vector<value_type> entries;
+    entries.reserve(size());
+    for (auto const &iter : *this) {
+      if (not directMap.inside(iter.first))
+        return;
+      entries.push_back(iter);
+    }
+    packedMap.clear();
+    arrayMap.clear();
+    directMap.reset(directMap.box);
+    direct = true;
+    packed = false;
+    for (auto const &e : entries)
+      directMap.insert(e.first, e.second);
+  }
+  // Move the entries of a direct map over to a hash table, for points outside
+  // the box
+  void undirect() {
+    DirectGridTable<dimension> d;
+    std::swap(d, directMap);
+    direct = false;
+    packed = true;
+    directThreshold = 0;
+    for (std::size_t i = 0; i < d.size(); i++)
+      insert(std::make_pair(d.point(d.cells[i]), d.values[i]));
+  }
+};
+
+// The offsets of a filter, in the order the rule generators number them, for
+// batched neighbour lookups with SparseGridMap::findNeighbours
+template <Int dimension> class SparseGridStencil {
+public:
+  std::vector<Point<dimension>> offsets;
+  // The offsets as increments of packed keys
+  std::vector<uint64_t> deltas;
+  // Smallest and largest offset along each axis
+  Point<dimension> lo, hi;
+  template <typename Region> SparseGridStencil(Region region) {
+    lo.fill(0);
+    hi.fill(0);
+    for (auto const &o : region) {
+      offsets.push_back(o);
+      uint64_t d = 0;
+      for (Int i = 0; i < dimension; i++) {
+        d += (uint64_t)(int64_t)o[i]
+             << (i * SparseGridMap<dimension>::packedBits);
+        lo[i] = std::min(lo[i], o[i]);
+        hi[i] = std::max(hi[i], o[i]);
+      }
+      deltas.push_back(d);
+    }
+  }
+  Int size() const { return offsets.size(); }
+};
+#endif /* SPARSEGRIDMAP_H */
@@ -6,6 +6,8 @@
 
 #ifndef VALIDCONVOLUTIONRULES_H
 #define VALIDCONVOLUTIONRULES_H
+#include "FixedStencil.h"
+#include "SiteChunks.h"
 
 // Full input region for an output point
 template <Int dimension>
@@ -22,68 +24,478 @@ InputRegionCalculator_Valid(const Point<dimension> &output, long *size) {
 
 // Call for each convolutional / max-pooling layer, once for each batch item.
 // rules is used to carry out the "lowering" whilst carrying out the convolution
+// Each neighbour is looked up once: the rules found are counted in rules, and
+// appended to found as (filter offset, input row, output row) triples, which
+// SubmanifoldConvolution_AddRules writes out after rules.allocate().
 
-template <Int dimension>
-double SubmanifoldConvolution_SgToRules(SparseGrid<dimension> &grid,
-                                        RuleBook &rules, long *size) {
+// The rules for the output sites [begin, end) of grid, with lookup one of the
+// neighbour lookups of FixedStencil.h
+template <Int dimension, typename Lookup>
+double SubmanifoldConvolution_SgToRules(
+    SparseGrid<dimension> &grid,
+    typename SparseGridMap<dimension>::iterator begin,
+    typename SparseGridMap<dimension>::iterator end, RuleBook &rules,
+    const SparseGridStencil<dimension> &stencil, Lookup lookup,
+    std::vector<Int> &found) {
   double countActiveInputs = 0;
-  for (auto const &outputIter : grid.mp) {
-    auto inRegion =
-        InputRegionCalculator_Valid<dimension>(outputIter.first, size);
-    Int rulesOffset = 0;
-    for (auto inputPoint : inRegion) {
-      auto inputIter = grid.mp.find(inputPoint);
-      if (inputIter != grid.mp.end()) {
-        rules[rulesOffset].push_back(inputIter->second + grid.ctr);
-        rules[rulesOffset].push_back(outputIter.second + grid.ctr);
+  Int sd = lookup.size(stencil);
+  std::vector<Int> inputRows(sd);
+  for (auto outputIter = begin; outputIter != end; ++outputIter) {
+    lookup(grid.mp, outputIter->first, stencil, &inputRows[0]);
+    for (Int rulesOffset = 0; rulesOffset < sd; rulesOffset++) {
+      Int inputRow = inputRows[rulesOffset];
+      if (inputRow >= 0) {
+        rules.count(rulesOffset);
+        found.insert(found.end(), {rulesOffset, inputRow + grid.ctr,
+                                   outputIter->second + grid.ctr});
         countActiveInputs++;
       }
-      rulesOffset++;
     }
   }
   return countActiveInputs;
 }
 
+template <Int dimension> class SubmanifoldConvolution_SgToRules_Fixed {
+public:
+  SparseGrid<dimension> &grid;
+  typename SparseGridMap<dimension>::iterator begin, end;
+  RuleBook &rules;
+  const SparseGridStencil<dimension> &stencil;
+  std::vector<Int> &found;
+  double countActiveInputs;
+  template <Int size> void run() {
+    countActiveInputs = SubmanifoldConvolution_SgToRules<dimension>(
+        grid, begin, end, rules, stencil,
+        FixedStencilLookup<dimension, size,
+                           FixedStencil<dimension, size>::volume>(),
+        found);
+  }
+};
+
+template <Int dimension>
+double SubmanifoldConvolution_SgToRules(
+    SparseGrid<dimension> &grid,
+    typename SparseGridMap<dimension>::iterator begin,
+    typename SparseGridMap<dimension>::iterator end, RuleBook &rules,
+    long *size, std::vector<Int> &found) {
+  Point<dimension> origin;
+  origin.fill(0);
+  // The filter offsets, in rulesOffset order; the neighbours of each output
+  // site are looked up in one batch
+  SparseGridStencil<dimension> stencil(
+      InputRegionCalculator_Valid<dimension>(origin, size));
+  SubmanifoldConvolution_SgToRules_Fixed<dimension> fixed{
+      grid, begin, end, rules, stencil, found, 0};
+  if (FixedStencils<dimension>::dispatch(size, fixed))
+    return fixed.countActiveInputs;
+  return SubmanifoldConvolution_SgToRules<dimension>(
+      grid, begin, end, rules, stencil, StencilLookup<dimension>(), found);
+}
+
+template <Int dimension>
+double SubmanifoldConvolution_SgToRules(SparseGrid<dimension> &grid,
+                                        RuleBook &rules, long *size,
+                                        std::vector<Int> &found) {
+  return SubmanifoldConvolution_SgToRules<dimension>(
+      grid, grid.mp.begin(), grid.mp.end(), rules, size, found);
+}
+
+// Write out the rules found, in order
+inline void SubmanifoldConvolution_AddRules(RuleBook &rules,
+                                            const std::vector<Int> &found) {
+  for (std::size_t j = 0; j < found.size(); j += 3)
+    rules.add(found[j], found[j + 1], found[j + 2]);
+}
+
 template <Int dimension>
 Int SubmanifoldConvolution_SgsToRules(SparseGrids<dimension> &SGs,
                                       RuleBook &rules, long *size) {
   Int sd = volume<dimension>(size);
   Int countActiveInputs = 0;
-  rules.clear();
-  rules.resize(sd);
+  std::vector<Int> found;
+  rules.startCounting(sd);
   for (Int i = 0; i < (Int)SGs.size(); i++)
     countActiveInputs +=
-        SubmanifoldConvolution_SgToRules<dimension>(SGs[i], rules, size);
+        SubmanifoldConvolution_SgToRules<dimension>(SGs[i], rules, size, found);
+  rules.allocate();
+  SubmanifoldConvolution_AddRules(rules, found);
   return countActiveInputs;
 }
 template <Int dimension>
 Int SubmanifoldConvolution_SgsToRules_OMP(SparseGrids<dimension> &SGs,
                                           RuleBook &rules, long *size) {
-  std::vector<RuleBook> rbs(SGs.size());
-  std::vector<double> countActiveInputs(SGs.size());
-  rules.clear();
+  auto chunks = SiteChunks<dimension>(SGs);
+  std::vector<RuleBook> rbs(chunks.size());
+  std::vector<double> countActiveInputs(chunks.size());
   Int sd = volume<dimension>(size);
-  rules.resize(sd);
   {
     Int i;
-#pragma omp parallel for private(i)
-    for (i = 0; i < (Int)SGs.size(); i++) {
-      rbs[i].resize(sd);
-      countActiveInputs[i] =
-          SubmanifoldConvolution_SgToRules<dimension>(SGs[i], rbs[i], size);
+#pragma omp parallel for schedule(dynamic) private(i)
+    for (i = 0; i < (Int)chunks.size(); i++) {
+      auto &c = chunks[i];
+      std::vector<Int> found;
+      rbs[i].startCounting(sd);
+      countActiveInputs[i] = SubmanifoldConvolution_SgToRules<dimension>(
+          SGs[c.sample], c.begin, c.end, rbs[i], size, found);
+      rbs[i].allocate();
+      SubmanifoldConvolution_AddRules(rbs[i], found);
     }
   }
-  {
-    Int i;
-#pragma omp parallel for private(i)
-    for (i = 0; i < sd; i++)
-      for (auto const &rb : rbs)
-        rules[i].insert(rules[i].end(), rb[i].begin(), rb[i].end());
-  }
+  rules.concatenate(rbs, sd, [](Int, Int r) { return r; }, true);
   Int countActiveInputs_ = 0;
   for (auto &i : countActiveInputs)
     countActiveInputs_ += i;
   return countActiveInputs_;
 }
 
+// Half-stencil rule generation, for filters of odd size along every axis.
+// Such a stencil is symmetric, offset sd - 1 - k being the mirror image of
+// offset k, so input i is at offset k from output j exactly when j is at
+// offset sd - 1 - k from i. Only the offsets up to the centre are looked up;
+// each neighbour found fills two entries of a nActive x sd table of input
+// rows (as in a NeighbourTable). The rules are then read out of the table in
+// the order of SubmanifoldConvolution_SgToRules, so the rulebooks come out
+// the same with about half the hash lookups. The table costs sd Ints per
+// site, so it is only used for filter volumes up to halfStencilMaxVolume.
+const Int halfStencilMaxVolume = 27;
+
+template <Int dimension> bool SubmanifoldConvolution_HalfStencil(long *size) {
+  for (Int i = 0; i < dimension; i++)
+    if (size[i] % 2 == 0)
+      return false;
+  return volume<dimension>(size) <= halfStencilMaxVolume;
+}
+
+// Look up the first half of the stencil for the sites [begin, end) of grid.
+// Rows of table are indexed by the rows of the sites (value + grid.ctr).
+// Returns the number of entries filled in.
+template <Int dimension, typename Lookup>
+long SubmanifoldConvolution_HalfStencilLookups(
+    SparseGrid<dimension> &grid,
+    typename SparseGridMap<dimension>::iterator begin,
+    typename SparseGridMap<dimension>::iterator end,
+    const SparseGridStencil<dimension> &half, Lookup lookup, Int sd,
+    Int *table) {
+  // half holds the offsets 0 ... centre
+  Int centre = lookup.size(half) - 1;
+  std::vector<Int> inputRows(centre + 1);
+  long filled = 0;
+  for (auto outputIter = begin; outputIter != end; ++outputIter) {
+    Int out = outputIter->second + grid.ctr;
+    lookup(grid.mp, outputIter->first, half, &inputRows[0]);
+    for (Int k = 0; k < centre; k++) {
+      if (inputRows[k] >= 0) {
+        Int in = inputRows[k] + grid.ctr;
+        table[(long)out * sd + k] = in;
+        table[(long)in * sd + sd - 1 - k] = out;
+        filled += 2;
+      }
+    }
+    table[(long)out * sd + centre] = out;
+    filled++;
+  }
+  return filled;
+}
+
+template <Int dimension> class SubmanifoldConvolution_HalfStencilLookups_Fixed {
+public:
+  SparseGrid<dimension> &grid;
+  typename SparseGridMap<dimension>::iterator begin, end;
+  const SparseGridStencil<dimension> &half;
+  Int sd;
+  Int *table;
+  long filled;
+  template <Int size> void run() {
+    filled = SubmanifoldConvolution_HalfStencilLookups<dimension>(
+        grid, begin, end, half,
+        FixedStencilLookup<dimension, size,
+                           FixedStencil<dimension, size>::volume / 2 + 1>(),
+        sd, table);
+  }
+};
+
+// Same counts and rules as SubmanifoldConvolution_SgToRules, from the table
+template <Int dimension>
+double SubmanifoldConvolution_HalfStencilRules(
+    SparseGrid<dimension> &grid,
+    typename SparseGridMap<dimension>::iterator begin,
+    typename SparseGridMap<dimension>::iterator end, const Int *table, Int sd,
+    RuleBook &rules, bool fill) {
+  double countActiveInputs = 0;
+  for (auto outputIter = begin; outputIter != end; ++outputIter) {
+    Int out = outputIter->second + grid.ctr;
+    const Int *inputRows = table + (long)out * sd;
+    for (Int rulesOffset = 0; rulesOffset < sd; rulesOffset++) {
+      if (inputRows[rulesOffset] >= 0) {
+        if (fill)
+          rules.add(rulesOffset, inputRows[rulesOffset], out);
+        else
+          rules.count(rulesOffset);
+        countActiveInputs++;
+      }
+    }
+  }
+  return countActiveInputs;
+}
+
+// The NeighbourTable of a submanifold convolution, looked up directly from
+// the grids: half the stencil for odd sizes, the whole of it otherwise
+template <Int dimension>
+void SubmanifoldConvolution_SgsToNeighbours(SparseGrids<dimension> &SGs,
+                                            NeighbourTable &table, long *size,
+                                            bool openMP) {
+  Point<dimension> origin;
+  origin.fill(0);
+  SparseGridStencil<dimension> stencil(
+      InputRegionCalculator_Valid<dimension>(origin, size));
+  Int sd = stencil.size();
+  bool odd = true;
+  for (Int i = 0; i < dimension; i++)
+    odd = odd and size[i] % 2 == 1;
+  std::vector<Point<dimension>> halfOffsets(stencil.offsets.begin(),
+                                            stencil.offsets.begin() + sd / 2 +
+                                                1);
+  SparseGridStencil<dimension> half(halfOffsets);
+  long nActive = 0;
+  for (auto &sg : SGs)
+    nActive += sg.mp.size();
+  table.assign(nActive * sd, -1);
+  auto chunks = SiteChunks<dimension>(SGs);
+  std::vector<long> filled(chunks.size());
+  Int i;
+  // Each entry of the table is written by at most one lookup
+#pragma omp parallel for schedule(dynamic) private(i) if (openMP)
+  for (i = 0; i < (Int)chunks.size(); i++) {
+    auto &c = chunks[i];
+    auto &grid = SGs[c.sample];
+    if (not odd) {
+      for (auto iter = c.begin; iter != c.end; ++iter) {
+        Int *inputRows = &table[(long)(iter->second + grid.ctr) * sd];
+        grid.mp.findNeighbours(iter->first, stencil, inputRows);
+        for (Int k = 0; k < sd; k++)
+          if (inputRows[k] >= 0) {
+            inputRows[k] += grid.ctr;
+            filled[i]++;
+          }
+      }
+      continue;
+    }
+    SubmanifoldConvolution_HalfStencilLookups_Fixed<dimension> fixed{
+        grid, c.begin, c.end, half, sd, &table[0], 0};
+    if (FixedStencils<dimension>::dispatch(size, fixed))
+      filled[i] = fixed.filled;
+    else
+      filled[i] = SubmanifoldConvolution_HalfStencilLookups<dimension>(
+          grid, c.begin, c.end, half, StencilLookup<dimension>(), sd,
+          &table[0]);
+  }
+  table.nRules = 0;
+  for (auto n : filled)
+    table.nRules += n;
+}
+
+// The rulebook held by a NeighbourTable, with the rules in the order of
+// SubmanifoldConvolution_SgToRules
+template <Int dimension>
+Int SubmanifoldConvolution_NeighboursToRules(SparseGrids<dimension> &SGs,
+                                             const NeighbourTable &table,
+                                             Int sd, RuleBook &rules,
+                                             bool openMP) {
+  double countActiveInputs = 0;
+  if (not openMP) {
+    rules.startCounting(sd);
+    for (auto &sg : SGs)
+      SubmanifoldConvolution_HalfStencilRules<dimension>(
+          sg, sg.mp.begin(), sg.mp.end(), &table[0], sd, rules, false);
+    rules.allocate();
+    for (auto &sg : SGs)
+      countActiveInputs += SubmanifoldConvolution_HalfStencilRules<dimension>(
+          sg, sg.mp.begin(), sg.mp.end(), &table[0], sd, rules, true);
+    return countActiveInputs;
+  }
+  auto chunks = SiteChunks<dimension>(SGs);
+  std::vector<RuleBook> rbs(chunks.size());
+  std::vector<double> chunkCounts(chunks.size());
+  Int i;
+#pragma omp parallel for schedule(dynamic) private(i)
+  for (i = 0; i < (Int)chunks.size(); i++) {
+    auto &c = chunks[i];
+    rbs[i].startCounting(sd);
+    SubmanifoldConvolution_HalfStencilRules<dimension>(
+        SGs[c.sample], c.begin, c.end, &table[0], sd, rbs[i], false);
+    rbs[i].allocate();
+    chunkCounts[i] = SubmanifoldConvolution_HalfStencilRules<dimension>(
+        SGs[c.sample], c.begin, c.end, &table[0], sd, rbs[i], true);
+  }
+  rules.concatenate(rbs, sd, [](Int, Int r) { return r; }, true);
+  for (auto &c : chunkCounts)
+    countActiveInputs += c;
+  return countActiveInputs;
+}
+
+template <Int dimension>
+Int SubmanifoldConvolution_SgsToRules_HalfStencil(SparseGrids<dimension> &SGs,
+                                                  RuleBook &rules, long *size,
+                                                  bool openMP) {
+  NeighbourTable table;
+  SubmanifoldConvolution_SgsToNeighbours<dimension>(SGs, table, size, openMP);
+  return SubmanifoldConvolution_NeighboursToRules<dimension>(
+      SGs, table, volume<dimension>(size), rules, openMP);
+}
+
+// Rulebooks for nested stencils. Along each axis a stencil of size s spans
+// the offsets -s/2 ... (s - 1)/2, so it contains the stencils of all the
+// smaller sizes, and the rules for an offset come in the same order whatever
+// the size of the stencil. A rulebook can thus be cut out of a larger one,
+// and a larger one needs only the offsets that a smaller one lacks looked up.
+
+// The position in the stencil of size largeSize of each offset of the stencil
+// of size size, or -1 for offsets that it lacks
+template <Int dimension>
+std::vector<Int> SubmanifoldConvolution_StencilIndex(long *size,
+                                                     long *largeSize) {
+  Point<dimension> origin;
+  origin.fill(0);
+  SparseGridStencil<dimension> stencil(
+      InputRegionCalculator_Valid<dimension>(origin, size));
+  SparseGridStencil<dimension> large(
+      InputRegionCalculator_Valid<dimension>(origin, largeSize));
+  std::vector<Int> index(stencil.size(), -1);
+  for (Int k = 0; k < stencil.size(); k++)
+    for (Int K = 0; K < large.size(); K++)
+      if (stencil.offsets[k] == large.offsets[K])
+        index[k] = K;
+  return index;
+}
+
+// Cut the rulebook for size out of large, the rulebook for largeSize
+template <Int dimension>
+void SubmanifoldConvolution_SelectRules(const RuleBook &large, RuleBook &rules,
+                                        long *largeSize, long *size,
+                                        bool openMP) {
+  auto index = SubmanifoldConvolution_StencilIndex<dimension>(size, largeSize);
+  Int sd = index.size();
+  rules.startCounting(sd);
+  for (Int k = 0; k < sd; k++)
+    rules.count(k, large.nRules(index[k]));
+  rules.allocate();
+  Int k;
+#pragma omp parallel for private(k) if (openMP)
+  for (k = 0; k < sd; k++)
+    std::copy(large[index[k]], large[index[k]] + 2 * large.nRules(index[k]),
+              rules[k]);
+}
+
+// The rules for the output sites [begin, end) of grid and the offsets of
+// stencil; the rules for stencil offset k go to offset index[k] of rules.
+template <Int dimension>
+void SubmanifoldConvolution_SgToStencilRules(
+    SparseGrid<dimension> &grid,
+    typename SparseGridMap<dimension>::iterator begin,
+    typename SparseGridMap<dimension>::iterator end,
+    const SparseGridStencil<dimension> &stencil, const std::vector<Int> &index,
+    RuleBook &rules, bool fill) {
+  std::vector<Int> inputRows(stencil.size());
+  for (auto outputIter = begin; outputIter != end; ++outputIter) {
+    grid.mp.findNeighbours(outputIter->first, stencil, &inputRows[0]);
+    for (Int k = 0; k < stencil.size(); k++) {
+      if (inputRows[k] >= 0) {
+        if (fill)
+          rules.add(index[k], inputRows[k] + grid.ctr,
+                    outputIter->second + grid.ctr);
+        else
+          rules.count(index[k]);
+      }
+    }
+  }
+}
+
+// Build the rulebook for size from small, the rulebook for smallSize
+template <Int dimension>
+void SubmanifoldConvolution_ExtendRules(SparseGrids<dimension> &SGs,
+                                        const RuleBook &small, RuleBook &rules,
+                                        long *smallSize, long *size,
+                                        bool openMP) {
+  auto index = SubmanifoldConvolution_StencilIndex<dimension>(smallSize, size);
+  Point<dimension> origin;
+  origin.fill(0);
+  SparseGridStencil<dimension> stencil(
+      InputRegionCalculator_Valid<dimension>(origin, size));
+  Int sd = stencil.size();
+  std::vector<bool> known(sd, false);
+  for (auto K : index)
+    known[K] = true;
+  // Look up the missing offsets only
+  std::vector<Point<dimension>> missingOffsets;
+  std::vector<Int> missing;
+  for (Int K = 0; K < sd; K++)
+    if (not known[K]) {
+      missingOffsets.push_back(stencil.offsets[K]);
+      missing.push_back(K);
+    }
+  SparseGridStencil<dimension> missingStencil(missingOffsets);
+  RuleBook extra;
+  if (openMP) {
+    auto chunks = SiteChunks<dimension>(SGs);
+    std::vector<RuleBook> rbs(chunks.size());
+    Int i;
+#pragma omp parallel for schedule(dynamic) private(i)
+    for (i = 0; i < (Int)chunks.size(); i++) {
+      auto &c = chunks[i];
+      rbs[i].startCounting(sd);
+      SubmanifoldConvolution_SgToStencilRules<dimension>(
+          SGs[c.sample], c.begin, c.end, missingStencil, missing, rbs[i],
+          false);
+      rbs[i].allocate();
+      SubmanifoldConvolution_SgToStencilRules<dimension>(
+          SGs[c.sample], c.begin, c.end, missingStencil, missing, rbs[i],
+          true);
+    }
+    extra.concatenate(rbs, sd, [](Int, Int r) { return r; }, true);
+  } else {
+    extra.startCounting(sd);
+    for (auto &sg : SGs)
+      SubmanifoldConvolution_SgToStencilRules<dimension>(
+          sg, sg.mp.begin(), sg.mp.end(), missingStencil, missing, extra,
+          false);
+    extra.allocate();
+    for (auto &sg : SGs)
+      SubmanifoldConvolution_SgToStencilRules<dimension>(
+          sg, sg.mp.begin(), sg.mp.end(), missingStencil, missing, extra,
+          true);
+  }
+  // Merge the rules of small with the new ones
+  std::vector<Int> from(sd, -1);
+  for (Int k = 0; k < (Int)index.size(); k++)
+    from[index[k]] = k;
+  rules.startCounting(sd);
+  for (Int K = 0; K < sd; K++)
+    rules.count(K, from[K] >= 0 ? small.nRules(from[K]) : extra.nRules(K));
+  rules.allocate();
+  Int K;
+#pragma omp parallel for private(K) if (openMP)
+  for (K = 0; K < sd; K++) {
+    const Int *r = from[K] >= 0 ? small[from[K]] : extra[K];
+    std::copy(r, r + 2 * rules.nRules(K), rules[K]);
+  }
+}
+
+// Output-stationary form of a submanifold rulebook: row j of the
+// nActive x filterVolume table holds, for each filter offset, the input row
+// that feeds output row j, or -1 if that neighbour is not active.
+inline void SubmanifoldConvolution_RulesToNeighbours(RuleBook &rules,
+                                                     NeighbourTable &table,
+                                                     Int nActive) {
+  Int sd = rules.size();
+  table.assign((long)nActive * sd, -1);
+  table.nRules = rules.nRules();
+  Int i;
+#pragma omp parallel for private(i)
+  for (i = 0; i < sd; i++) {
+    Int *r = rules[i];
+    for (Int j = 0; j < rules.nRules(i); j++)
+      table[(long)r[2 * j + 1] * sd + i] = r[2 * j];
+  }
+}
+
 #endif /* VALIDCONVOLUTIONRULES_H */
@@ -493,6 +493,16 @@ void cpu_UnPooling_updateGradInput<double,1>(at::Tensor inputSize, at::Tensor ou
                                    at::Tensor d_input_features,
                                    at::Tensor d_output_features,
                                    long nFeaturesToDrop);
+template
+double cpu_OutputStationarySubmanifoldConvolution_updateOutput<float,1>(
+    at::Tensor inputSize, at::Tensor filterSize, Metadata<1> &m,
+    at::Tensor input_features, at::Tensor output_features, at::Tensor weight,
+    at::Tensor bias);
+template
+double cpu_OutputStationarySubmanifoldConvolution_updateOutput<double,1>(
+    at::Tensor inputSize, at::Tensor filterSize, Metadata<1> &m,
+    at::Tensor input_features, at::Tensor output_features, at::Tensor weight,
+    at::Tensor bias);
 
 template
 void cpu_ActivePooling_updateOutput<float,2>(at::Tensor inputSize,
@@ -827,6 +837,16 @@ void cpu_UnPooling_updateGradInput<double,2>(at::Tensor inputSize, at::Tensor ou
                                    at::Tensor d_input_features,
                                    at::Tensor d_output_features,
                                    long nFeaturesToDrop);
+template
+double cpu_OutputStationarySubmanifoldConvolution_updateOutput<float,2>(
+    at::Tensor inputSize, at::Tensor filterSize, Metadata<2> &m,
+    at::Tensor input_features, at::Tensor output_features, at::Tensor weight,
+    at::Tensor bias);
+template
+double cpu_OutputStationarySubmanifoldConvolution_updateOutput<double,2>(
+    at::Tensor inputSize, at::Tensor filterSize, Metadata<2> &m,
+    at::Tensor input_features, at::Tensor output_features, at::Tensor weight,
+    at::Tensor bias);
 
 template
 void cpu_ActivePooling_updateOutput<float,3>(at::Tensor inputSize,
@@ -1161,6 +1181,16 @@ void cpu_UnPooling_updateGradInput<double,3>(at::Tensor inputSize, at::Tensor ou
                                    at::Tensor d_input_features,
                                    at::Tensor d_output_features,
                                    long nFeaturesToDrop);
+template
+double cpu_OutputStationarySubmanifoldConvolution_updateOutput<float,3>(
+    at::Tensor inputSize, at::Tensor filterSize, Metadata<3> &m,
+    at::Tensor input_features, at::Tensor output_features, at::Tensor weight,
+    at::Tensor bias);
+template
+double cpu_OutputStationarySubmanifoldConvolution_updateOutput<double,3>(
+    at::Tensor inputSize, at::Tensor filterSize, Metadata<3> &m,
+    at::Tensor input_features, at::Tensor output_features, at::Tensor weight,
+    at::Tensor bias);
 
 template
 void cpu_ActivePooling_updateOutput<float,4>(at::Tensor inputSize,
@@ -1495,3 +1525,13 @@ void cpu_UnPooling_updateGradInput<double,4>(at::Tensor inputSize, at::Tensor ou
                                    at::Tensor d_input_features,
                                    at::Tensor d_output_features,
                                    long nFeaturesToDrop);
+template
+double cpu_OutputStationarySubmanifoldConvolution_updateOutput<float,4>(
+    at::Tensor inputSize, at::Tensor filterSize, Metadata<4> &m,
+    at::Tensor input_features, at::Tensor output_features, at::Tensor weight,
+    at::Tensor bias);
+template
+double cpu_OutputStationarySubmanifoldConvolution_updateOutput<double,4>(
+    at::Tensor inputSize, at::Tensor filterSize, Metadata<4> &m,
+    at::Tensor input_features, at::Tensor output_features, at::Tensor weight,
+    at::Tensor bias);
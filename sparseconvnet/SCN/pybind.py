@@ -319,10 +319,19 @@ void ARCH_UnPooling_updateGradInput<REAL,DIMENSION>(at::Tensor inputSize, at::Te
                                    at::Tensor d_output_features,
                                    long nFeaturesToDrop);
 """
+# CPU only
+cpu_code="""template
+double cpu_OutputStationarySubmanifoldConvolution_updateOutput<REAL,DIMENSION>(
+    at::Tensor inputSize, at::Tensor filterSize, Metadata<DIMENSION> &m,
+    at::Tensor input_features, at::Tensor output_features, at::Tensor weight,
+    at::Tensor bias);
+"""
 for dimension in range(1,5):
     f_cpu.write(code.replace('ARCH', 'cpu').replace('REAL', 'float').replace('DIMENSION', str(dimension)))
     f_cpu.write(code.replace('ARCH', 'cpu').replace('REAL', 'double').replace('DIMENSION', str(dimension)))
     f_cuda.write(code.replace('ARCH', 'cuda').replace('REAL', 'float').replace('DIMENSION', str(dimension)))
+    f_cpu.write(cpu_code.replace('REAL', 'float').replace('DIMENSION', str(dimension)))
+    f_cpu.write(cpu_code.replace('REAL', 'double').replace('DIMENSION', str(dimension)))
 
 f_cpu.close()
 f_cuda.close()
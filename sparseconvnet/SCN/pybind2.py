@@ -15,6 +15,9 @@ txt="""
 // LICENSE file in the root directory of this source tree.
 
 #include <torch/torch.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 #include "Metadata/Metadata.h"
 """
@@ -253,6 +256,17 @@ f_cpu.write(txt)
 f_cuda.write(txt)
 f_cuda.write(txt.replace('cpu','cuda'))
 
+# CPU only
+txt="""
+template <typename T, Int Dimension>
+double cpu_OutputStationarySubmanifoldConvolution_updateOutput(
+    at::Tensor inputSize, at::Tensor filterSize, Metadata<Dimension> &m,
+    at::Tensor input_features, at::Tensor output_features, at::Tensor weight,
+    at::Tensor bias);
+"""
+f_cpu.write(txt)
+f_cuda.write(txt)
+
 
 # txt="""
 # void cpu_float_DrawCurve_2(Metadata<2> &m, at::Tensor features,
@@ -281,23 +295,48 @@ pybind11::class_<Metadata<DIMENSION>>(m, "Metadata_DIMENSION")
   .def("sparsifyMetadata", &Metadata<DIMENSION>::sparsifyMetadata)
   .def("addSampleFromThresholdedTensor", &Metadata<DIMENSION>::addSampleFromThresholdedTensor)
   .def("generateRuleBooks3s2", &Metadata<DIMENSION>::generateRuleBooks3s2)
-  .def("generateRuleBooks2s2", &Metadata<DIMENSION>::generateRuleBooks2s2);
+  .def("generateRuleBooks2s2", &Metadata<DIMENSION>::generateRuleBooks2s2)
+  .def("precomputeRuleBooks", &Metadata<DIMENSION>::precomputeRuleBooks)
+  .def("startLookahead", &Metadata<DIMENSION>::startLookahead)
+  .def("finishLookahead", &Metadata<DIMENSION>::finishLookahead)
+  .def("recordRuleBooks", &Metadata<DIMENSION>::recordRuleBooks)
+  .def("getRecordedPlan", &Metadata<DIMENSION>::getRecordedPlan)
+  .def("setSortedRuleBooks", &Metadata<DIMENSION>::setSortedRuleBooks)
+  .def("mortonOrderInput", &Metadata<DIMENSION>::mortonOrderInput)
+  .def("inputKey", &Metadata<DIMENSION>::inputKey)
+  .def("saveRuleBooks", &Metadata<DIMENSION>::saveRuleBooks)
+  .def("loadRuleBooks", &Metadata<DIMENSION>::loadRuleBooks)
+  .def("serializeRuleBooks", &Metadata<DIMENSION>::serializeRuleBooks)
+  .def("deserializeRuleBooks", &Metadata<DIMENSION>::deserializeRuleBooks);
 """.replace('DIMENSION', str(DIMENSION)))
 
+# The CPU kernels release the GIL, so that the branches of a ConcatTable can
+# run in parallel (see tables.py); the CUDA ones only queue work on the GPU
+release_gil = ', pybind11::call_guard<pybind11::gil_scoped_release>()'
+
 def typed_fn(st):
-    st='m.def("ARCH_REAL_'+st+'", &ARCH_'+st+'<REAL>, "");\n'
+    st='m.def("ARCH_REAL_'+st+'", &ARCH_'+st+'<REAL>, ""GUARD);\n'
+    cpu=st.replace('ARCH', 'cpu').replace('GUARD', release_gil)
     for f in [f_cpu, f_cuda]:
-        f.write(st.replace('ARCH', 'cpu').replace('REAL', 'float'))
-        f.write(st.replace('ARCH', 'cpu').replace('REAL', 'double'))
-    f_cuda.write(st.replace('ARCH', 'cuda').replace('REAL', 'float'))
+        f.write(cpu.replace('REAL', 'float'))
+        f.write(cpu.replace('REAL', 'double'))
+    f_cuda.write(st.replace('ARCH', 'cuda').replace('REAL', 'float').replace('GUARD', ''))
 
 def dim_typed_fn(st):
-    st='m.def("ARCH_REAL_'+st+'_DIMENSION", &ARCH_'+st+'<REAL,DIMENSION>, "");\n'
+    st='m.def("ARCH_REAL_'+st+'_DIMENSION", &ARCH_'+st+'<REAL,DIMENSION>, ""GUARD);\n'
+    cpu=st.replace('ARCH', 'cpu').replace('GUARD', release_gil)
+    for DIMENSION in range(1,5):
+        for f in [f_cpu, f_cuda]:
+            f.write(cpu.replace('DIMENSION', str(DIMENSION)).replace('REAL', 'float'))
+            f.write(cpu.replace('DIMENSION', str(DIMENSION)).replace('REAL', 'double'))
+        f_cuda.write(st.replace('DIMENSION', str(DIMENSION)).replace('ARCH', 'cuda').replace('REAL', 'float').replace('GUARD', ''))
+
+def cpu_dim_typed_fn(st):
+    st='m.def("cpu_REAL_'+st+'_DIMENSION", &cpu_'+st+'<REAL,DIMENSION>, ""'+release_gil+');\n'
     for DIMENSION in range(1,5):
         for f in [f_cpu, f_cuda]:
-            f.write(st.replace('DIMENSION', str(DIMENSION)).replace('ARCH', 'cpu').replace('REAL', 'float'))
-            f.write(st.replace('DIMENSION', str(DIMENSION)).replace('ARCH', 'cpu').replace('REAL', 'double'))
-        f_cuda.write(st.replace('DIMENSION', str(DIMENSION)).replace('ARCH', 'cuda').replace('REAL', 'float'))
+            f.write(st.replace('DIMENSION', str(DIMENSION)).replace('REAL', 'float'))
+            f.write(st.replace('DIMENSION', str(DIMENSION)).replace('REAL', 'double'))
 
 typed_fn("AffineReluTrivialConvolution_updateOutput")
 typed_fn("AffineReluTrivialConvolution_backward")
@@ -330,6 +369,7 @@ dim_typed_fn("SparseToDense_updateOutput")
 dim_typed_fn("SparseToDense_updateGradInput")
 dim_typed_fn("SubmanifoldConvolution_updateOutput")
 dim_typed_fn("SubmanifoldConvolution_backward")
+cpu_dim_typed_fn("OutputStationarySubmanifoldConvolution_updateOutput")
 dim_typed_fn("InputLayer_updateOutput")
 dim_typed_fn("InputLayer_updateGradInput")
 dim_typed_fn("OutputLayer_updateOutput")
@@ -345,6 +385,21 @@ for f in [f_cpu, f_cuda]:
     f.write(
 """
 m.def("n_rulebook_bits", []() {return 8*sizeof(Int);}, "");
+// Bytes allocated by rulebook copies and CPU convolution scratch space so far
+m.def("scratch_bytes", []() {return scratchBytes().load();}, "");
+// The size of the OpenMP teams that the CPU kernels of the calling thread use
+m.def("get_omp_threads", []() {
+#if defined(_OPENMP)
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}, "");
+m.def("set_omp_threads", [](int n) {
+#if defined(_OPENMP)
+  omp_set_num_threads(n);
+#endif
+}, "");
 }
 """)
 
@@ -6,6 +6,9 @@
 // LICENSE file in the root directory of this source tree.
 
 #include <torch/torch.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 #include "Metadata/Metadata.h"
 
@@ -236,6 +239,12 @@ void cpu_UnPooling_updateGradInput(at::Tensor inputSize, at::Tensor outputSize,
                                    at::Tensor d_output_features,
                                    long nFeaturesToDrop);
 
+template <typename T, Int Dimension>
+double cpu_OutputStationarySubmanifoldConvolution_updateOutput(
+    at::Tensor inputSize, at::Tensor filterSize, Metadata<Dimension> &m,
+    at::Tensor input_features, at::Tensor output_features, at::Tensor weight,
+    at::Tensor bias);
+
 PYBIND11_MODULE(TORCH_EXTENSION_NAME, m) {
 
 pybind11::class_<Metadata<1>>(m, "Metadata_1")
@@ -250,7 +259,19 @@ pybind11::class_<Metadata<1>>(m, "Metadata_1")
   .def("sparsifyMetadata", &Metadata<1>::sparsifyMetadata)
   .def("addSampleFromThresholdedTensor", &Metadata<1>::addSampleFromThresholdedTensor)
   .def("generateRuleBooks3s2", &Metadata<1>::generateRuleBooks3s2)
-  .def("generateRuleBooks2s2", &Metadata<1>::generateRuleBooks2s2);
+  .def("generateRuleBooks2s2", &Metadata<1>::generateRuleBooks2s2)
+  .def("precomputeRuleBooks", &Metadata<1>::precomputeRuleBooks)
+  .def("startLookahead", &Metadata<1>::startLookahead)
+  .def("finishLookahead", &Metadata<1>::finishLookahead)
+  .def("recordRuleBooks", &Metadata<1>::recordRuleBooks)
+  .def("getRecordedPlan", &Metadata<1>::getRecordedPlan)
+  .def("setSortedRuleBooks", &Metadata<1>::setSortedRuleBooks)
+  .def("mortonOrderInput", &Metadata<1>::mortonOrderInput)
+  .def("inputKey", &Metadata<1>::inputKey)
+  .def("saveRuleBooks", &Metadata<1>::saveRuleBooks)
+  .def("loadRuleBooks", &Metadata<1>::loadRuleBooks)
+  .def("serializeRuleBooks", &Metadata<1>::serializeRuleBooks)
+  .def("deserializeRuleBooks", &Metadata<1>::deserializeRuleBooks);
 
 pybind11::class_<Metadata<2>>(m, "Metadata_2")
   .def(pybind11::init<>())
@@ -264,7 +285,19 @@ pybind11::class_<Metadata<2>>(m, "Metadata_2")
   .def("sparsifyMetadata", &Metadata<2>::sparsifyMetadata)
   .def("addSampleFromThresholdedTensor", &Metadata<2>::addSampleFromThresholdedTensor)
   .def("generateRuleBooks3s2", &Metadata<2>::generateRuleBooks3s2)
-  .def("generateRuleBooks2s2", &Metadata<2>::generateRuleBooks2s2);
+  .def("generateRuleBooks2s2", &Metadata<2>::generateRuleBooks2s2)
+  .def("precomputeRuleBooks", &Metadata<2>::precomputeRuleBooks)
+  .def("startLookahead", &Metadata<2>::startLookahead)
+  .def("finishLookahead", &Metadata<2>::finishLookahead)
+  .def("recordRuleBooks", &Metadata<2>::recordRuleBooks)
+  .def("getRecordedPlan", &Metadata<2>::getRecordedPlan)
+  .def("setSortedRuleBooks", &Metadata<2>::setSortedRuleBooks)
+  .def("mortonOrderInput", &Metadata<2>::mortonOrderInput)
+  .def("inputKey", &Metadata<2>::inputKey)
+  .def("saveRuleBooks", &Metadata<2>::saveRuleBooks)
+  .def("loadRuleBooks", &Metadata<2>::loadRuleBooks)
+  .def("serializeRuleBooks", &Metadata<2>::serializeRuleBooks)
+  .def("deserializeRuleBooks", &Metadata<2>::deserializeRuleBooks);
 
 pybind11::class_<Metadata<3>>(m, "Metadata_3")
   .def(pybind11::init<>())
@@ -278,7 +311,19 @@ pybind11::class_<Metadata<3>>(m, "Metadata_3")
   .def("sparsifyMetadata", &Metadata<3>::sparsifyMetadata)
   .def("addSampleFromThresholdedTensor", &Metadata<3>::addSampleFromThresholdedTensor)
   .def("generateRuleBooks3s2", &Metadata<3>::generateRuleBooks3s2)
-  .def("generateRuleBooks2s2", &Metadata<3>::generateRuleBooks2s2);
+  .def("generateRuleBooks2s2", &Metadata<3>::generateRuleBooks2s2)
+  .def("precomputeRuleBooks", &Metadata<3>::precomputeRuleBooks)
+  .def("startLookahead", &Metadata<3>::startLookahead)
+  .def("finishLookahead", &Metadata<3>::finishLookahead)
+  .def("recordRuleBooks", &Metadata<3>::recordRuleBooks)
+  .def("getRecordedPlan", &Metadata<3>::getRecordedPlan)
+  .def("setSortedRuleBooks", &Metadata<3>::setSortedRuleBooks)
+  .def("mortonOrderInput", &Metadata<3>::mortonOrderInput)
+  .def("inputKey", &Metadata<3>::inputKey)
+  .def("saveRuleBooks", &Metadata<3>::saveRuleBooks)
+  .def("loadRuleBooks", &Metadata<3>::loadRuleBooks)
+  .def("serializeRuleBooks", &Metadata<3>::serializeRuleBooks)
+  .def("deserializeRuleBooks", &Metadata<3>::deserializeRuleBooks);
 
 pybind11::class_<Metadata<4>>(m, "Metadata_4")
   .def(pybind11::init<>())
@@ -292,269 +337,304 @@ pybind11::class_<Metadata<4>>(m, "Metadata_4")
   .def("sparsifyMetadata", &Metadata<4>::sparsifyMetadata)
   .def("addSampleFromThresholdedTensor", &Metadata<4>::addSampleFromThresholdedTensor)
   .def("generateRuleBooks3s2", &Metadata<4>::generateRuleBooks3s2)
-  .def("generateRuleBooks2s2", &Metadata<4>::generateRuleBooks2s2);
-m.def("cpu_float_AffineReluTrivialConvolution_updateOutput", &cpu_AffineReluTrivialConvolution_updateOutput<float>, "");
-m.def("cpu_double_AffineReluTrivialConvolution_updateOutput", &cpu_AffineReluTrivialConvolution_updateOutput<double>, "");
-m.def("cpu_float_AffineReluTrivialConvolution_backward", &cpu_AffineReluTrivialConvolution_backward<float>, "");
-m.def("cpu_double_AffineReluTrivialConvolution_backward", &cpu_AffineReluTrivialConvolution_backward<double>, "");
-m.def("cpu_float_BatchwiseMultiplicativeDropout_updateOutput", &cpu_BatchwiseMultiplicativeDropout_updateOutput<float>, "");
-m.def("cpu_double_BatchwiseMultiplicativeDropout_updateOutput", &cpu_BatchwiseMultiplicativeDropout_updateOutput<double>, "");
-m.def("cpu_float_BatchwiseMultiplicativeDropout_updateGradInput", &cpu_BatchwiseMultiplicativeDropout_updateGradInput<float>, "");
-m.def("cpu_double_BatchwiseMultiplicativeDropout_updateGradInput", &cpu_BatchwiseMultiplicativeDropout_updateGradInput<double>, "");
-m.def("cpu_float_BatchNormalization_updateOutput", &cpu_BatchNormalization_updateOutput<float>, "");
-m.def("cpu_double_BatchNormalization_updateOutput", &cpu_BatchNormalization_updateOutput<double>, "");
-m.def("cpu_float_BatchNormalization_backward", &cpu_BatchNormalization_backward<float>, "");
-m.def("cpu_double_BatchNormalization_backward", &cpu_BatchNormalization_backward<double>, "");
-m.def("cpu_float_LeakyReLU_updateOutput", &cpu_LeakyReLU_updateOutput<float>, "");
-m.def("cpu_double_LeakyReLU_updateOutput", &cpu_LeakyReLU_updateOutput<double>, "");
-m.def("cpu_float_LeakyReLU_updateGradInput", &cpu_LeakyReLU_updateGradInput<float>, "");
-m.def("cpu_double_LeakyReLU_updateGradInput", &cpu_LeakyReLU_updateGradInput<double>, "");
-m.def("cpu_float_NetworkInNetwork_updateOutput", &cpu_NetworkInNetwork_updateOutput<float>, "");
-m.def("cpu_double_NetworkInNetwork_updateOutput", &cpu_NetworkInNetwork_updateOutput<double>, "");
-m.def("cpu_float_NetworkInNetwork_updateGradInput", &cpu_NetworkInNetwork_updateGradInput<float>, "");
-m.def("cpu_double_NetworkInNetwork_updateGradInput", &cpu_NetworkInNetwork_updateGradInput<double>, "");
-m.def("cpu_float_NetworkInNetwork_accGradParameters", &cpu_NetworkInNetwork_accGradParameters<float>, "");
-m.def("cpu_double_NetworkInNetwork_accGradParameters", &cpu_NetworkInNetwork_accGradParameters<double>, "");
-m.def("cpu_float_ActivePooling_updateOutput_1", &cpu_ActivePooling_updateOutput<float,1>, "");
-m.def("cpu_double_ActivePooling_updateOutput_1", &cpu_ActivePooling_updateOutput<double,1>, "");
-m.def("cpu_float_ActivePooling_updateOutput_2", &cpu_ActivePooling_updateOutput<float,2>, "");
-m.def("cpu_double_ActivePooling_updateOutput_2", &cpu_ActivePooling_updateOutput<double,2>, "");
-m.def("cpu_float_ActivePooling_updateOutput_3", &cpu_ActivePooling_updateOutput<float,3>, "");
-m.def("cpu_double_ActivePooling_updateOutput_3", &cpu_ActivePooling_updateOutput<double,3>, "");
-m.def("cpu_float_ActivePooling_updateOutput_4", &cpu_ActivePooling_updateOutput<float,4>, "");
-m.def("cpu_double_ActivePooling_updateOutput_4", &cpu_ActivePooling_updateOutput<double,4>, "");
-m.def("cpu_float_ActivePooling_updateGradInput_1", &cpu_ActivePooling_updateGradInput<float,1>, "");
-m.def("cpu_double_ActivePooling_updateGradInput_1", &cpu_ActivePooling_updateGradInput<double,1>, "");
-m.def("cpu_float_ActivePooling_updateGradInput_2", &cpu_ActivePooling_updateGradInput<float,2>, "");
-m.def("cpu_double_ActivePooling_updateGradInput_2", &cpu_ActivePooling_updateGradInput<double,2>, "");
-m.def("cpu_float_ActivePooling_updateGradInput_3", &cpu_ActivePooling_updateGradInput<float,3>, "");
-m.def("cpu_double_ActivePooling_updateGradInput_3", &cpu_ActivePooling_updateGradInput<double,3>, "");
-m.def("cpu_float_ActivePooling_updateGradInput_4", &cpu_ActivePooling_updateGradInput<float,4>, "");
-m.def("cpu_double_ActivePooling_updateGradInput_4", &cpu_ActivePooling_updateGradInput<double,4>, "");
-m.def("cpu_float_AveragePooling_updateOutput_1", &cpu_AveragePooling_updateOutput<float,1>, "");
-m.def("cpu_double_AveragePooling_updateOutput_1", &cpu_AveragePooling_updateOutput<double,1>, "");
-m.def("cpu_float_AveragePooling_updateOutput_2", &cpu_AveragePooling_updateOutput<float,2>, "");
-m.def("cpu_double_AveragePooling_updateOutput_2", &cpu_AveragePooling_updateOutput<double,2>, "");
-m.def("cpu_float_AveragePooling_updateOutput_3", &cpu_AveragePooling_updateOutput<float,3>, "");
-m.def("cpu_double_AveragePooling_updateOutput_3", &cpu_AveragePooling_updateOutput<double,3>, "");
-m.def("cpu_float_AveragePooling_updateOutput_4", &cpu_AveragePooling_updateOutput<float,4>, "");
-m.def("cpu_double_AveragePooling_updateOutput_4", &cpu_AveragePooling_updateOutput<double,4>, "");
-m.def("cpu_float_AveragePooling_updateGradInput_1", &cpu_AveragePooling_updateGradInput<float,1>, "");
-m.def("cpu_double_AveragePooling_updateGradInput_1", &cpu_AveragePooling_updateGradInput<double,1>, "");
-m.def("cpu_float_AveragePooling_updateGradInput_2", &cpu_AveragePooling_updateGradInput<float,2>, "");
-m.def("cpu_double_AveragePooling_updateGradInput_2", &cpu_AveragePooling_updateGradInput<double,2>, "");
-m.def("cpu_float_AveragePooling_updateGradInput_3", &cpu_AveragePooling_updateGradInput<float,3>, "");
-m.def("cpu_double_AveragePooling_updateGradInput_3", &cpu_AveragePooling_updateGradInput<double,3>, "");
-m.def("cpu_float_AveragePooling_updateGradInput_4", &cpu_AveragePooling_updateGradInput<float,4>, "");
-m.def("cpu_double_AveragePooling_updateGradInput_4", &cpu_AveragePooling_updateGradInput<double,4>, "");
-m.def("cpu_float_Convolution_updateOutput_1", &cpu_Convolution_updateOutput<float,1>, "");
-m.def("cpu_double_Convolution_updateOutput_1", &cpu_Convolution_updateOutput<double,1>, "");
-m.def("cpu_float_Convolution_updateOutput_2", &cpu_Convolution_updateOutput<float,2>, "");
-m.def("cpu_double_Convolution_updateOutput_2", &cpu_Convolution_updateOutput<double,2>, "");
-m.def("cpu_float_Convolution_updateOutput_3", &cpu_Convolution_updateOutput<float,3>, "");
-m.def("cpu_double_Convolution_updateOutput_3", &cpu_Convolution_updateOutput<double,3>, "");
-m.def("cpu_float_Convolution_updateOutput_4", &cpu_Convolution_updateOutput<float,4>, "");
-m.def("cpu_double_Convolution_updateOutput_4", &cpu_Convolution_updateOutput<double,4>, "");
-m.def("cpu_float_Convolution_backward_1", &cpu_Convolution_backward<float,1>, "");
-m.def("cpu_double_Convolution_backward_1", &cpu_Convolution_backward<double,1>, "");
-m.def("cpu_float_Convolution_backward_2", &cpu_Convolution_backward<float,2>, "");
-m.def("cpu_double_Convolution_backward_2", &cpu_Convolution_backward<double,2>, "");
-m.def("cpu_float_Convolution_backward_3", &cpu_Convolution_backward<float,3>, "");
-m.def("cpu_double_Convolution_backward_3", &cpu_Convolution_backward<double,3>, "");
-m.def("cpu_float_Convolution_backward_4", &cpu_Convolution_backward<float,4>, "");
-m.def("cpu_double_Convolution_backward_4", &cpu_Convolution_backward<double,4>, "");
-m.def("cpu_float_RandomizedStrideConvolution_updateOutput_1", &cpu_RandomizedStrideConvolution_updateOutput<float,1>, "");
-m.def("cpu_double_RandomizedStrideConvolution_updateOutput_1", &cpu_RandomizedStrideConvolution_updateOutput<double,1>, "");
-m.def("cpu_float_RandomizedStrideConvolution_updateOutput_2", &cpu_RandomizedStrideConvolution_updateOutput<float,2>, "");
-m.def("cpu_double_RandomizedStrideConvolution_updateOutput_2", &cpu_RandomizedStrideConvolution_updateOutput<double,2>, "");
-m.def("cpu_float_RandomizedStrideConvolution_updateOutput_3", &cpu_RandomizedStrideConvolution_updateOutput<float,3>, "");
-m.def("cpu_double_RandomizedStrideConvolution_updateOutput_3", &cpu_RandomizedStrideConvolution_updateOutput<double,3>, "");
-m.def("cpu_float_RandomizedStrideConvolution_updateOutput_4", &cpu_RandomizedStrideConvolution_updateOutput<float,4>, "");
-m.def("cpu_double_RandomizedStrideConvolution_updateOutput_4", &cpu_RandomizedStrideConvolution_updateOutput<double,4>, "");
-m.def("cpu_float_RandomizedStrideConvolution_backward_1", &cpu_RandomizedStrideConvolution_backward<float,1>, "");
-m.def("cpu_double_RandomizedStrideConvolution_backward_1", &cpu_RandomizedStrideConvolution_backward<double,1>, "");
-m.def("cpu_float_RandomizedStrideConvolution_backward_2", &cpu_RandomizedStrideConvolution_backward<float,2>, "");
-m.def("cpu_double_RandomizedStrideConvolution_backward_2", &cpu_RandomizedStrideConvolution_backward<double,2>, "");
-m.def("cpu_float_RandomizedStrideConvolution_backward_3", &cpu_RandomizedStrideConvolution_backward<float,3>, "");
-m.def("cpu_double_RandomizedStrideConvolution_backward_3", &cpu_RandomizedStrideConvolution_backward<double,3>, "");
-m.def("cpu_float_RandomizedStrideConvolution_backward_4", &cpu_RandomizedStrideConvolution_backward<float,4>, "");
-m.def("cpu_double_RandomizedStrideConvolution_backward_4", &cpu_RandomizedStrideConvolution_backward<double,4>, "");
-m.def("cpu_float_Deconvolution_updateOutput_1", &cpu_Deconvolution_updateOutput<float,1>, "");
-m.def("cpu_double_Deconvolution_updateOutput_1", &cpu_Deconvolution_updateOutput<double,1>, "");
-m.def("cpu_float_Deconvolution_updateOutput_2", &cpu_Deconvolution_updateOutput<float,2>, "");
-m.def("cpu_double_Deconvolution_updateOutput_2", &cpu_Deconvolution_updateOutput<double,2>, "");
-m.def("cpu_float_Deconvolution_updateOutput_3", &cpu_Deconvolution_updateOutput<float,3>, "");
-m.def("cpu_double_Deconvolution_updateOutput_3", &cpu_Deconvolution_updateOutput<double,3>, "");
-m.def("cpu_float_Deconvolution_updateOutput_4", &cpu_Deconvolution_updateOutput<float,4>, "");
-m.def("cpu_double_Deconvolution_updateOutput_4", &cpu_Deconvolution_updateOutput<double,4>, "");
-m.def("cpu_float_Deconvolution_backward_1", &cpu_Deconvolution_backward<float,1>, "");
-m.def("cpu_double_Deconvolution_backward_1", &cpu_Deconvolution_backward<double,1>, "");
-m.def("cpu_float_Deconvolution_backward_2", &cpu_Deconvolution_backward<float,2>, "");
-m.def("cpu_double_Deconvolution_backward_2", &cpu_Deconvolution_backward<double,2>, "");
-m.def("cpu_float_Deconvolution_backward_3", &cpu_Deconvolution_backward<float,3>, "");
-m.def("cpu_double_Deconvolution_backward_3", &cpu_Deconvolution_backward<double,3>, "");
-m.def("cpu_float_Deconvolution_backward_4", &cpu_Deconvolution_backward<float,4>, "");
-m.def("cpu_double_Deconvolution_backward_4", &cpu_Deconvolution_backward<double,4>, "");
-m.def("cpu_float_FullConvolution_updateOutput_1", &cpu_FullConvolution_updateOutput<float,1>, "");
-m.def("cpu_double_FullConvolution_updateOutput_1", &cpu_FullConvolution_updateOutput<double,1>, "");
-m.def("cpu_float_FullConvolution_updateOutput_2", &cpu_FullConvolution_updateOutput<float,2>, "");
-m.def("cpu_double_FullConvolution_updateOutput_2", &cpu_FullConvolution_updateOutput<double,2>, "");
-m.def("cpu_float_FullConvolution_updateOutput_3", &cpu_FullConvolution_updateOutput<float,3>, "");
-m.def("cpu_double_FullConvolution_updateOutput_3", &cpu_FullConvolution_updateOutput<double,3>, "");
-m.def("cpu_float_FullConvolution_updateOutput_4", &cpu_FullConvolution_updateOutput<float,4>, "");
-m.def("cpu_double_FullConvolution_updateOutput_4", &cpu_FullConvolution_updateOutput<double,4>, "");
-m.def("cpu_float_FullConvolution_backward_1", &cpu_FullConvolution_backward<float,1>, "");
-m.def("cpu_double_FullConvolution_backward_1", &cpu_FullConvolution_backward<double,1>, "");
-m.def("cpu_float_FullConvolution_backward_2", &cpu_FullConvolution_backward<float,2>, "");
-m.def("cpu_double_FullConvolution_backward_2", &cpu_FullConvolution_backward<double,2>, "");
-m.def("cpu_float_FullConvolution_backward_3", &cpu_FullConvolution_backward<float,3>, "");
-m.def("cpu_double_FullConvolution_backward_3", &cpu_FullConvolution_backward<double,3>, "");
-m.def("cpu_float_FullConvolution_backward_4", &cpu_FullConvolution_backward<float,4>, "");
-m.def("cpu_double_FullConvolution_backward_4", &cpu_FullConvolution_backward<double,4>, "");
-m.def("cpu_float_MaxPooling_updateOutput_1", &cpu_MaxPooling_updateOutput<float,1>, "");
-m.def("cpu_double_MaxPooling_updateOutput_1", &cpu_MaxPooling_updateOutput<double,1>, "");
-m.def("cpu_float_MaxPooling_updateOutput_2", &cpu_MaxPooling_updateOutput<float,2>, "");
-m.def("cpu_double_MaxPooling_updateOutput_2", &cpu_MaxPooling_updateOutput<double,2>, "");
-m.def("cpu_float_MaxPooling_updateOutput_3", &cpu_MaxPooling_updateOutput<float,3>, "");
-m.def("cpu_double_MaxPooling_updateOutput_3", &cpu_MaxPooling_updateOutput<double,3>, "");
-m.def("cpu_float_MaxPooling_updateOutput_4", &cpu_MaxPooling_updateOutput<float,4>, "");
-m.def("cpu_double_MaxPooling_updateOutput_4", &cpu_MaxPooling_updateOutput<double,4>, "");
-m.def("cpu_float_MaxPooling_updateGradInput_1", &cpu_MaxPooling_updateGradInput<float,1>, "");
-m.def("cpu_double_MaxPooling_updateGradInput_1", &cpu_MaxPooling_updateGradInput<double,1>, "");
-m.def("cpu_float_MaxPooling_updateGradInput_2", &cpu_MaxPooling_updateGradInput<float,2>, "");
-m.def("cpu_double_MaxPooling_updateGradInput_2", &cpu_MaxPooling_updateGradInput<double,2>, "");
-m.def("cpu_float_MaxPooling_updateGradInput_3", &cpu_MaxPooling_updateGradInput<float,3>, "");
-m.def("cpu_double_MaxPooling_updateGradInput_3", &cpu_MaxPooling_updateGradInput<double,3>, "");
-m.def("cpu_float_MaxPooling_updateGradInput_4", &cpu_MaxPooling_updateGradInput<float,4>, "");
-m.def("cpu_double_MaxPooling_updateGradInput_4", &cpu_MaxPooling_updateGradInput<double,4>, "");
-m.def("cpu_float_RandomizedStrideMaxPooling_updateOutput_1", &cpu_RandomizedStrideMaxPooling_updateOutput<float,1>, "");
-m.def("cpu_double_RandomizedStrideMaxPooling_updateOutput_1", &cpu_RandomizedStrideMaxPooling_updateOutput<double,1>, "");
-m.def("cpu_float_RandomizedStrideMaxPooling_updateOutput_2", &cpu_RandomizedStrideMaxPooling_updateOutput<float,2>, "");
-m.def("cpu_double_RandomizedStrideMaxPooling_updateOutput_2", &cpu_RandomizedStrideMaxPooling_updateOutput<double,2>, "");
-m.def("cpu_float_RandomizedStrideMaxPooling_updateOutput_3", &cpu_RandomizedStrideMaxPooling_updateOutput<float,3>, "");
-m.def("cpu_double_RandomizedStrideMaxPooling_updateOutput_3", &cpu_RandomizedStrideMaxPooling_updateOutput<double,3>, "");
-m.def("cpu_float_RandomizedStrideMaxPooling_updateOutput_4", &cpu_RandomizedStrideMaxPooling_updateOutput<float,4>, "");
-m.def("cpu_double_RandomizedStrideMaxPooling_updateOutput_4", &cpu_RandomizedStrideMaxPooling_updateOutput<double,4>, "");
-m.def("cpu_float_RandomizedStrideMaxPooling_updateGradInput_1", &cpu_RandomizedStrideMaxPooling_updateGradInput<float,1>, "");
-m.def("cpu_double_RandomizedStrideMaxPooling_updateGradInput_1", &cpu_RandomizedStrideMaxPooling_updateGradInput<double,1>, "");
-m.def("cpu_float_RandomizedStrideMaxPooling_updateGradInput_2", &cpu_RandomizedStrideMaxPooling_updateGradInput<float,2>, "");
-m.def("cpu_double_RandomizedStrideMaxPooling_updateGradInput_2", &cpu_RandomizedStrideMaxPooling_updateGradInput<double,2>, "");
-m.def("cpu_float_RandomizedStrideMaxPooling_updateGradInput_3", &cpu_RandomizedStrideMaxPooling_updateGradInput<float,3>, "");
-m.def("cpu_double_RandomizedStrideMaxPooling_updateGradInput_3", &cpu_RandomizedStrideMaxPooling_updateGradInput<double,3>, "");
-m.def("cpu_float_RandomizedStrideMaxPooling_updateGradInput_4", &cpu_RandomizedStrideMaxPooling_updateGradInput<float,4>, "");
-m.def("cpu_double_RandomizedStrideMaxPooling_updateGradInput_4", &cpu_RandomizedStrideMaxPooling_updateGradInput<double,4>, "");
-m.def("cpu_float_SparseToDense_updateOutput_1", &cpu_SparseToDense_updateOutput<float,1>, "");
-m.def("cpu_double_SparseToDense_updateOutput_1", &cpu_SparseToDense_updateOutput<double,1>, "");
-m.def("cpu_float_SparseToDense_updateOutput_2", &cpu_SparseToDense_updateOutput<float,2>, "");
-m.def("cpu_double_SparseToDense_updateOutput_2", &cpu_SparseToDense_updateOutput<double,2>, "");
-m.def("cpu_float_SparseToDense_updateOutput_3", &cpu_SparseToDense_updateOutput<float,3>, "");
-m.def("cpu_double_SparseToDense_updateOutput_3", &cpu_SparseToDense_updateOutput<double,3>, "");
-m.def("cpu_float_SparseToDense_updateOutput_4", &cpu_SparseToDense_updateOutput<float,4>, "");
-m.def("cpu_double_SparseToDense_updateOutput_4", &cpu_SparseToDense_updateOutput<double,4>, "");
-m.def("cpu_float_SparseToDense_updateGradInput_1", &cpu_SparseToDense_updateGradInput<float,1>, "");
-m.def("cpu_double_SparseToDense_updateGradInput_1", &cpu_SparseToDense_updateGradInput<double,1>, "");
-m.def("cpu_float_SparseToDense_updateGradInput_2", &cpu_SparseToDense_updateGradInput<float,2>, "");
-m.def("cpu_double_SparseToDense_updateGradInput_2", &cpu_SparseToDense_updateGradInput<double,2>, "");
-m.def("cpu_float_SparseToDense_updateGradInput_3", &cpu_SparseToDense_updateGradInput<float,3>, "");
-m.def("cpu_double_SparseToDense_updateGradInput_3", &cpu_SparseToDense_updateGradInput<double,3>, "");
-m.def("cpu_float_SparseToDense_updateGradInput_4", &cpu_SparseToDense_updateGradInput<float,4>, "");
-m.def("cpu_double_SparseToDense_updateGradInput_4", &cpu_SparseToDense_updateGradInput<double,4>, "");
-m.def("cpu_float_SubmanifoldConvolution_updateOutput_1", &cpu_SubmanifoldConvolution_updateOutput<float,1>, "");
-m.def("cpu_double_SubmanifoldConvolution_updateOutput_1", &cpu_SubmanifoldConvolution_updateOutput<double,1>, "");
-m.def("cpu_float_SubmanifoldConvolution_updateOutput_2", &cpu_SubmanifoldConvolution_updateOutput<float,2>, "");
-m.def("cpu_double_SubmanifoldConvolution_updateOutput_2", &cpu_SubmanifoldConvolution_updateOutput<double,2>, "");
-m.def("cpu_float_SubmanifoldConvolution_updateOutput_3", &cpu_SubmanifoldConvolution_updateOutput<float,3>, "");
-m.def("cpu_double_SubmanifoldConvolution_updateOutput_3", &cpu_SubmanifoldConvolution_updateOutput<double,3>, "");
-m.def("cpu_float_SubmanifoldConvolution_updateOutput_4", &cpu_SubmanifoldConvolution_updateOutput<float,4>, "");
-m.def("cpu_double_SubmanifoldConvolution_updateOutput_4", &cpu_SubmanifoldConvolution_updateOutput<double,4>, "");
-m.def("cpu_float_SubmanifoldConvolution_backward_1", &cpu_SubmanifoldConvolution_backward<float,1>, "");
-m.def("cpu_double_SubmanifoldConvolution_backward_1", &cpu_SubmanifoldConvolution_backward<double,1>, "");
-m.def("cpu_float_SubmanifoldConvolution_backward_2", &cpu_SubmanifoldConvolution_backward<float,2>, "");
-m.def("cpu_double_SubmanifoldConvolution_backward_2", &cpu_SubmanifoldConvolution_backward<double,2>, "");
-m.def("cpu_float_SubmanifoldConvolution_backward_3", &cpu_SubmanifoldConvolution_backward<float,3>, "");
-m.def("cpu_double_SubmanifoldConvolution_backward_3", &cpu_SubmanifoldConvolution_backward<double,3>, "");
-m.def("cpu_float_SubmanifoldConvolution_backward_4", &cpu_SubmanifoldConvolution_backward<float,4>, "");
-m.def("cpu_double_SubmanifoldConvolution_backward_4", &cpu_SubmanifoldConvolution_backward<double,4>, "");
-m.def("cpu_float_InputLayer_updateOutput_1", &cpu_InputLayer_updateOutput<float,1>, "");
-m.def("cpu_double_InputLayer_updateOutput_1", &cpu_InputLayer_updateOutput<double,1>, "");
-m.def("cpu_float_InputLayer_updateOutput_2", &cpu_InputLayer_updateOutput<float,2>, "");
-m.def("cpu_double_InputLayer_updateOutput_2", &cpu_InputLayer_updateOutput<double,2>, "");
-m.def("cpu_float_InputLayer_updateOutput_3", &cpu_InputLayer_updateOutput<float,3>, "");
-m.def("cpu_double_InputLayer_updateOutput_3", &cpu_InputLayer_updateOutput<double,3>, "");
-m.def("cpu_float_InputLayer_updateOutput_4", &cpu_InputLayer_updateOutput<float,4>, "");
-m.def("cpu_double_InputLayer_updateOutput_4", &cpu_InputLayer_updateOutput<double,4>, "");
-m.def("cpu_float_InputLayer_updateGradInput_1", &cpu_InputLayer_updateGradInput<float,1>, "");
-m.def("cpu_double_InputLayer_updateGradInput_1", &cpu_InputLayer_updateGradInput<double,1>, "");
-m.def("cpu_float_InputLayer_updateGradInput_2", &cpu_InputLayer_updateGradInput<float,2>, "");
-m.def("cpu_double_InputLayer_updateGradInput_2", &cpu_InputLayer_updateGradInput<double,2>, "");
-m.def("cpu_float_InputLayer_updateGradInput_3", &cpu_InputLayer_updateGradInput<float,3>, "");
-m.def("cpu_double_InputLayer_updateGradInput_3", &cpu_InputLayer_updateGradInput<double,3>, "");
-m.def("cpu_float_InputLayer_updateGradInput_4", &cpu_InputLayer_updateGradInput<float,4>, "");
-m.def("cpu_double_InputLayer_updateGradInput_4", &cpu_InputLayer_updateGradInput<double,4>, "");
-m.def("cpu_float_OutputLayer_updateOutput_1", &cpu_OutputLayer_updateOutput<float,1>, "");
-m.def("cpu_double_OutputLayer_updateOutput_1", &cpu_OutputLayer_updateOutput<double,1>, "");
-m.def("cpu_float_OutputLayer_updateOutput_2", &cpu_OutputLayer_updateOutput<float,2>, "");
-m.def("cpu_double_OutputLayer_updateOutput_2", &cpu_OutputLayer_updateOutput<double,2>, "");
-m.def("cpu_float_OutputLayer_updateOutput_3", &cpu_OutputLayer_updateOutput<float,3>, "");
-m.def("cpu_double_OutputLayer_updateOutput_3", &cpu_OutputLayer_updateOutput<double,3>, "");
-m.def("cpu_float_OutputLayer_updateOutput_4", &cpu_OutputLayer_updateOutput<float,4>, "");
-m.def("cpu_double_OutputLayer_updateOutput_4", &cpu_OutputLayer_updateOutput<double,4>, "");
-m.def("cpu_float_OutputLayer_updateGradInput_1", &cpu_OutputLayer_updateGradInput<float,1>, "");
-m.def("cpu_double_OutputLayer_updateGradInput_1", &cpu_OutputLayer_updateGradInput<double,1>, "");
-m.def("cpu_float_OutputLayer_updateGradInput_2", &cpu_OutputLayer_updateGradInput<float,2>, "");
-m.def("cpu_double_OutputLayer_updateGradInput_2", &cpu_OutputLayer_updateGradInput<double,2>, "");
-m.def("cpu_float_OutputLayer_updateGradInput_3", &cpu_OutputLayer_updateGradInput<float,3>, "");
-m.def("cpu_double_OutputLayer_updateGradInput_3", &cpu_OutputLayer_updateGradInput<double,3>, "");
-m.def("cpu_float_OutputLayer_updateGradInput_4", &cpu_OutputLayer_updateGradInput<float,4>, "");
-m.def("cpu_double_OutputLayer_updateGradInput_4", &cpu_OutputLayer_updateGradInput<double,4>, "");
-m.def("cpu_float_BLInputLayer_updateOutput_1", &cpu_BLInputLayer_updateOutput<float,1>, "");
-m.def("cpu_double_BLInputLayer_updateOutput_1", &cpu_BLInputLayer_updateOutput<double,1>, "");
-m.def("cpu_float_BLInputLayer_updateOutput_2", &cpu_BLInputLayer_updateOutput<float,2>, "");
-m.def("cpu_double_BLInputLayer_updateOutput_2", &cpu_BLInputLayer_updateOutput<double,2>, "");
-m.def("cpu_float_BLInputLayer_updateOutput_3", &cpu_BLInputLayer_updateOutput<float,3>, "");
-m.def("cpu_double_BLInputLayer_updateOutput_3", &cpu_BLInputLayer_updateOutput<double,3>, "");
-m.def("cpu_float_BLInputLayer_updateOutput_4", &cpu_BLInputLayer_updateOutput<float,4>, "");
-m.def("cpu_double_BLInputLayer_updateOutput_4", &cpu_BLInputLayer_updateOutput<double,4>, "");
-m.def("cpu_float_BLInputLayer_updateGradInput_1", &cpu_BLInputLayer_updateGradInput<float,1>, "");
-m.def("cpu_double_BLInputLayer_updateGradInput_1", &cpu_BLInputLayer_updateGradInput<double,1>, "");
-m.def("cpu_float_BLInputLayer_updateGradInput_2", &cpu_BLInputLayer_updateGradInput<float,2>, "");
-m.def("cpu_double_BLInputLayer_updateGradInput_2", &cpu_BLInputLayer_updateGradInput<double,2>, "");
-m.def("cpu_float_BLInputLayer_updateGradInput_3", &cpu_BLInputLayer_updateGradInput<float,3>, "");
-m.def("cpu_double_BLInputLayer_updateGradInput_3", &cpu_BLInputLayer_updateGradInput<double,3>, "");
-m.def("cpu_float_BLInputLayer_updateGradInput_4", &cpu_BLInputLayer_updateGradInput<float,4>, "");
-m.def("cpu_double_BLInputLayer_updateGradInput_4", &cpu_BLInputLayer_updateGradInput<double,4>, "");
-m.def("cpu_float_BLOutputLayer_updateOutput_1", &cpu_BLOutputLayer_updateOutput<float,1>, "");
-m.def("cpu_double_BLOutputLayer_updateOutput_1", &cpu_BLOutputLayer_updateOutput<double,1>, "");
-m.def("cpu_float_BLOutputLayer_updateOutput_2", &cpu_BLOutputLayer_updateOutput<float,2>, "");
-m.def("cpu_double_BLOutputLayer_updateOutput_2", &cpu_BLOutputLayer_updateOutput<double,2>, "");
-m.def("cpu_float_BLOutputLayer_updateOutput_3", &cpu_BLOutputLayer_updateOutput<float,3>, "");
-m.def("cpu_double_BLOutputLayer_updateOutput_3", &cpu_BLOutputLayer_updateOutput<double,3>, "");
-m.def("cpu_float_BLOutputLayer_updateOutput_4", &cpu_BLOutputLayer_updateOutput<float,4>, "");
-m.def("cpu_double_BLOutputLayer_updateOutput_4", &cpu_BLOutputLayer_updateOutput<double,4>, "");
-m.def("cpu_float_BLOutputLayer_updateGradInput_1", &cpu_BLOutputLayer_updateGradInput<float,1>, "");
-m.def("cpu_double_BLOutputLayer_updateGradInput_1", &cpu_BLOutputLayer_updateGradInput<double,1>, "");
-m.def("cpu_float_BLOutputLayer_updateGradInput_2", &cpu_BLOutputLayer_updateGradInput<float,2>, "");
-m.def("cpu_double_BLOutputLayer_updateGradInput_2", &cpu_BLOutputLayer_updateGradInput<double,2>, "");
-m.def("cpu_float_BLOutputLayer_updateGradInput_3", &cpu_BLOutputLayer_updateGradInput<float,3>, "");
-m.def("cpu_double_BLOutputLayer_updateGradInput_3", &cpu_BLOutputLayer_updateGradInput<double,3>, "");
-m.def("cpu_float_BLOutputLayer_updateGradInput_4", &cpu_BLOutputLayer_updateGradInput<float,4>, "");
-m.def("cpu_double_BLOutputLayer_updateGradInput_4", &cpu_BLOutputLayer_updateGradInput<double,4>, "");
-m.def("cpu_float_UnPooling_updateOutput_1", &cpu_UnPooling_updateOutput<float,1>, "");
-m.def("cpu_double_UnPooling_updateOutput_1", &cpu_UnPooling_updateOutput<double,1>, "");
-m.def("cpu_float_UnPooling_updateOutput_2", &cpu_UnPooling_updateOutput<float,2>, "");
-m.def("cpu_double_UnPooling_updateOutput_2", &cpu_UnPooling_updateOutput<double,2>, "");
-m.def("cpu_float_UnPooling_updateOutput_3", &cpu_UnPooling_updateOutput<float,3>, "");
-m.def("cpu_double_UnPooling_updateOutput_3", &cpu_UnPooling_updateOutput<double,3>, "");
-m.def("cpu_float_UnPooling_updateOutput_4", &cpu_UnPooling_updateOutput<float,4>, "");
-m.def("cpu_double_UnPooling_updateOutput_4", &cpu_UnPooling_updateOutput<double,4>, "");
-m.def("cpu_float_UnPooling_updateGradInput_1", &cpu_UnPooling_updateGradInput<float,1>, "");
-m.def("cpu_double_UnPooling_updateGradInput_1", &cpu_UnPooling_updateGradInput<double,1>, "");
-m.def("cpu_float_UnPooling_updateGradInput_2", &cpu_UnPooling_updateGradInput<float,2>, "");
-m.def("cpu_double_UnPooling_updateGradInput_2", &cpu_UnPooling_updateGradInput<double,2>, "");
-m.def("cpu_float_UnPooling_updateGradInput_3", &cpu_UnPooling_updateGradInput<float,3>, "");
-m.def("cpu_double_UnPooling_updateGradInput_3", &cpu_UnPooling_updateGradInput<double,3>, "");
-m.def("cpu_float_UnPooling_updateGradInput_4", &cpu_UnPooling_updateGradInput<float,4>, "");
-m.def("cpu_double_UnPooling_updateGradInput_4", &cpu_UnPooling_updateGradInput<double,4>, "");
+  .def("generateRuleBooks2s2", &Metadata<4>::generateRuleBooks2s2)
+  .def("precomputeRuleBooks", &Metadata<4>::precomputeRuleBooks)
+  .def("startLookahead", &Metadata<4>::startLookahead)
+  .def("finishLookahead", &Metadata<4>::finishLookahead)
+  .def("recordRuleBooks", &Metadata<4>::recordRuleBooks)
+  .def("getRecordedPlan", &Metadata<4>::getRecordedPlan)
+  .def("setSortedRuleBooks", &Metadata<4>::setSortedRuleBooks)
+  .def("mortonOrderInput", &Metadata<4>::mortonOrderInput)
+  .def("inputKey", &Metadata<4>::inputKey)
+  .def("saveRuleBooks", &Metadata<4>::saveRuleBooks)
+  .def("loadRuleBooks", &Metadata<4>::loadRuleBooks)
+  .def("serializeRuleBooks", &Metadata<4>::serializeRuleBooks)
+  .def("deserializeRuleBooks", &Metadata<4>::deserializeRuleBooks);
+m.def("cpu_float_AffineReluTrivialConvolution_updateOutput", &cpu_AffineReluTrivialConvolution_updateOutput<float>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_AffineReluTrivialConvolution_updateOutput", &cpu_AffineReluTrivialConvolution_updateOutput<double>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_AffineReluTrivialConvolution_backward", &cpu_AffineReluTrivialConvolution_backward<float>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_AffineReluTrivialConvolution_backward", &cpu_AffineReluTrivialConvolution_backward<double>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BatchwiseMultiplicativeDropout_updateOutput", &cpu_BatchwiseMultiplicativeDropout_updateOutput<float>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BatchwiseMultiplicativeDropout_updateOutput", &cpu_BatchwiseMultiplicativeDropout_updateOutput<double>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BatchwiseMultiplicativeDropout_updateGradInput", &cpu_BatchwiseMultiplicativeDropout_updateGradInput<float>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BatchwiseMultiplicativeDropout_updateGradInput", &cpu_BatchwiseMultiplicativeDropout_updateGradInput<double>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BatchNormalization_updateOutput", &cpu_BatchNormalization_updateOutput<float>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BatchNormalization_updateOutput", &cpu_BatchNormalization_updateOutput<double>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BatchNormalization_backward", &cpu_BatchNormalization_backward<float>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BatchNormalization_backward", &cpu_BatchNormalization_backward<double>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_LeakyReLU_updateOutput", &cpu_LeakyReLU_updateOutput<float>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_LeakyReLU_updateOutput", &cpu_LeakyReLU_updateOutput<double>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_LeakyReLU_updateGradInput", &cpu_LeakyReLU_updateGradInput<float>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_LeakyReLU_updateGradInput", &cpu_LeakyReLU_updateGradInput<double>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_NetworkInNetwork_updateOutput", &cpu_NetworkInNetwork_updateOutput<float>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_NetworkInNetwork_updateOutput", &cpu_NetworkInNetwork_updateOutput<double>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_NetworkInNetwork_updateGradInput", &cpu_NetworkInNetwork_updateGradInput<float>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_NetworkInNetwork_updateGradInput", &cpu_NetworkInNetwork_updateGradInput<double>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_NetworkInNetwork_accGradParameters", &cpu_NetworkInNetwork_accGradParameters<float>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_NetworkInNetwork_accGradParameters", &cpu_NetworkInNetwork_accGradParameters<double>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_ActivePooling_updateOutput_1", &cpu_ActivePooling_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_ActivePooling_updateOutput_1", &cpu_ActivePooling_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_ActivePooling_updateOutput_2", &cpu_ActivePooling_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_ActivePooling_updateOutput_2", &cpu_ActivePooling_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_ActivePooling_updateOutput_3", &cpu_ActivePooling_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_ActivePooling_updateOutput_3", &cpu_ActivePooling_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_ActivePooling_updateOutput_4", &cpu_ActivePooling_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_ActivePooling_updateOutput_4", &cpu_ActivePooling_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_ActivePooling_updateGradInput_1", &cpu_ActivePooling_updateGradInput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_ActivePooling_updateGradInput_1", &cpu_ActivePooling_updateGradInput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_ActivePooling_updateGradInput_2", &cpu_ActivePooling_updateGradInput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_ActivePooling_updateGradInput_2", &cpu_ActivePooling_updateGradInput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_ActivePooling_updateGradInput_3", &cpu_ActivePooling_updateGradInput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_ActivePooling_updateGradInput_3", &cpu_ActivePooling_updateGradInput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_ActivePooling_updateGradInput_4", &cpu_ActivePooling_updateGradInput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_ActivePooling_updateGradInput_4", &cpu_ActivePooling_updateGradInput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_AveragePooling_updateOutput_1", &cpu_AveragePooling_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_AveragePooling_updateOutput_1", &cpu_AveragePooling_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_AveragePooling_updateOutput_2", &cpu_AveragePooling_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_AveragePooling_updateOutput_2", &cpu_AveragePooling_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_AveragePooling_updateOutput_3", &cpu_AveragePooling_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_AveragePooling_updateOutput_3", &cpu_AveragePooling_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_AveragePooling_updateOutput_4", &cpu_AveragePooling_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_AveragePooling_updateOutput_4", &cpu_AveragePooling_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_AveragePooling_updateGradInput_1", &cpu_AveragePooling_updateGradInput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_AveragePooling_updateGradInput_1", &cpu_AveragePooling_updateGradInput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_AveragePooling_updateGradInput_2", &cpu_AveragePooling_updateGradInput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_AveragePooling_updateGradInput_2", &cpu_AveragePooling_updateGradInput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_AveragePooling_updateGradInput_3", &cpu_AveragePooling_updateGradInput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_AveragePooling_updateGradInput_3", &cpu_AveragePooling_updateGradInput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_AveragePooling_updateGradInput_4", &cpu_AveragePooling_updateGradInput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_AveragePooling_updateGradInput_4", &cpu_AveragePooling_updateGradInput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Convolution_updateOutput_1", &cpu_Convolution_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Convolution_updateOutput_1", &cpu_Convolution_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Convolution_updateOutput_2", &cpu_Convolution_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Convolution_updateOutput_2", &cpu_Convolution_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Convolution_updateOutput_3", &cpu_Convolution_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Convolution_updateOutput_3", &cpu_Convolution_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Convolution_updateOutput_4", &cpu_Convolution_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Convolution_updateOutput_4", &cpu_Convolution_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Convolution_backward_1", &cpu_Convolution_backward<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Convolution_backward_1", &cpu_Convolution_backward<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Convolution_backward_2", &cpu_Convolution_backward<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Convolution_backward_2", &cpu_Convolution_backward<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Convolution_backward_3", &cpu_Convolution_backward<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Convolution_backward_3", &cpu_Convolution_backward<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Convolution_backward_4", &cpu_Convolution_backward<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Convolution_backward_4", &cpu_Convolution_backward<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideConvolution_updateOutput_1", &cpu_RandomizedStrideConvolution_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideConvolution_updateOutput_1", &cpu_RandomizedStrideConvolution_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideConvolution_updateOutput_2", &cpu_RandomizedStrideConvolution_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideConvolution_updateOutput_2", &cpu_RandomizedStrideConvolution_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideConvolution_updateOutput_3", &cpu_RandomizedStrideConvolution_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideConvolution_updateOutput_3", &cpu_RandomizedStrideConvolution_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideConvolution_updateOutput_4", &cpu_RandomizedStrideConvolution_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideConvolution_updateOutput_4", &cpu_RandomizedStrideConvolution_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideConvolution_backward_1", &cpu_RandomizedStrideConvolution_backward<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideConvolution_backward_1", &cpu_RandomizedStrideConvolution_backward<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideConvolution_backward_2", &cpu_RandomizedStrideConvolution_backward<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideConvolution_backward_2", &cpu_RandomizedStrideConvolution_backward<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideConvolution_backward_3", &cpu_RandomizedStrideConvolution_backward<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideConvolution_backward_3", &cpu_RandomizedStrideConvolution_backward<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideConvolution_backward_4", &cpu_RandomizedStrideConvolution_backward<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideConvolution_backward_4", &cpu_RandomizedStrideConvolution_backward<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Deconvolution_updateOutput_1", &cpu_Deconvolution_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Deconvolution_updateOutput_1", &cpu_Deconvolution_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Deconvolution_updateOutput_2", &cpu_Deconvolution_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Deconvolution_updateOutput_2", &cpu_Deconvolution_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Deconvolution_updateOutput_3", &cpu_Deconvolution_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Deconvolution_updateOutput_3", &cpu_Deconvolution_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Deconvolution_updateOutput_4", &cpu_Deconvolution_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Deconvolution_updateOutput_4", &cpu_Deconvolution_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Deconvolution_backward_1", &cpu_Deconvolution_backward<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Deconvolution_backward_1", &cpu_Deconvolution_backward<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Deconvolution_backward_2", &cpu_Deconvolution_backward<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Deconvolution_backward_2", &cpu_Deconvolution_backward<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Deconvolution_backward_3", &cpu_Deconvolution_backward<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Deconvolution_backward_3", &cpu_Deconvolution_backward<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_Deconvolution_backward_4", &cpu_Deconvolution_backward<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_Deconvolution_backward_4", &cpu_Deconvolution_backward<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_FullConvolution_updateOutput_1", &cpu_FullConvolution_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_FullConvolution_updateOutput_1", &cpu_FullConvolution_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_FullConvolution_updateOutput_2", &cpu_FullConvolution_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_FullConvolution_updateOutput_2", &cpu_FullConvolution_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_FullConvolution_updateOutput_3", &cpu_FullConvolution_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_FullConvolution_updateOutput_3", &cpu_FullConvolution_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_FullConvolution_updateOutput_4", &cpu_FullConvolution_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_FullConvolution_updateOutput_4", &cpu_FullConvolution_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_FullConvolution_backward_1", &cpu_FullConvolution_backward<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_FullConvolution_backward_1", &cpu_FullConvolution_backward<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_FullConvolution_backward_2", &cpu_FullConvolution_backward<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_FullConvolution_backward_2", &cpu_FullConvolution_backward<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_FullConvolution_backward_3", &cpu_FullConvolution_backward<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_FullConvolution_backward_3", &cpu_FullConvolution_backward<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_FullConvolution_backward_4", &cpu_FullConvolution_backward<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_FullConvolution_backward_4", &cpu_FullConvolution_backward<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_MaxPooling_updateOutput_1", &cpu_MaxPooling_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_MaxPooling_updateOutput_1", &cpu_MaxPooling_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_MaxPooling_updateOutput_2", &cpu_MaxPooling_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_MaxPooling_updateOutput_2", &cpu_MaxPooling_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_MaxPooling_updateOutput_3", &cpu_MaxPooling_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_MaxPooling_updateOutput_3", &cpu_MaxPooling_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_MaxPooling_updateOutput_4", &cpu_MaxPooling_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_MaxPooling_updateOutput_4", &cpu_MaxPooling_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_MaxPooling_updateGradInput_1", &cpu_MaxPooling_updateGradInput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_MaxPooling_updateGradInput_1", &cpu_MaxPooling_updateGradInput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_MaxPooling_updateGradInput_2", &cpu_MaxPooling_updateGradInput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_MaxPooling_updateGradInput_2", &cpu_MaxPooling_updateGradInput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_MaxPooling_updateGradInput_3", &cpu_MaxPooling_updateGradInput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_MaxPooling_updateGradInput_3", &cpu_MaxPooling_updateGradInput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_MaxPooling_updateGradInput_4", &cpu_MaxPooling_updateGradInput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_MaxPooling_updateGradInput_4", &cpu_MaxPooling_updateGradInput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideMaxPooling_updateOutput_1", &cpu_RandomizedStrideMaxPooling_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideMaxPooling_updateOutput_1", &cpu_RandomizedStrideMaxPooling_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideMaxPooling_updateOutput_2", &cpu_RandomizedStrideMaxPooling_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideMaxPooling_updateOutput_2", &cpu_RandomizedStrideMaxPooling_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideMaxPooling_updateOutput_3", &cpu_RandomizedStrideMaxPooling_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideMaxPooling_updateOutput_3", &cpu_RandomizedStrideMaxPooling_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideMaxPooling_updateOutput_4", &cpu_RandomizedStrideMaxPooling_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideMaxPooling_updateOutput_4", &cpu_RandomizedStrideMaxPooling_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideMaxPooling_updateGradInput_1", &cpu_RandomizedStrideMaxPooling_updateGradInput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideMaxPooling_updateGradInput_1", &cpu_RandomizedStrideMaxPooling_updateGradInput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideMaxPooling_updateGradInput_2", &cpu_RandomizedStrideMaxPooling_updateGradInput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideMaxPooling_updateGradInput_2", &cpu_RandomizedStrideMaxPooling_updateGradInput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideMaxPooling_updateGradInput_3", &cpu_RandomizedStrideMaxPooling_updateGradInput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideMaxPooling_updateGradInput_3", &cpu_RandomizedStrideMaxPooling_updateGradInput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_RandomizedStrideMaxPooling_updateGradInput_4", &cpu_RandomizedStrideMaxPooling_updateGradInput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_RandomizedStrideMaxPooling_updateGradInput_4", &cpu_RandomizedStrideMaxPooling_updateGradInput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SparseToDense_updateOutput_1", &cpu_SparseToDense_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SparseToDense_updateOutput_1", &cpu_SparseToDense_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SparseToDense_updateOutput_2", &cpu_SparseToDense_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SparseToDense_updateOutput_2", &cpu_SparseToDense_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SparseToDense_updateOutput_3", &cpu_SparseToDense_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SparseToDense_updateOutput_3", &cpu_SparseToDense_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SparseToDense_updateOutput_4", &cpu_SparseToDense_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SparseToDense_updateOutput_4", &cpu_SparseToDense_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SparseToDense_updateGradInput_1", &cpu_SparseToDense_updateGradInput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SparseToDense_updateGradInput_1", &cpu_SparseToDense_updateGradInput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SparseToDense_updateGradInput_2", &cpu_SparseToDense_updateGradInput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SparseToDense_updateGradInput_2", &cpu_SparseToDense_updateGradInput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SparseToDense_updateGradInput_3", &cpu_SparseToDense_updateGradInput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SparseToDense_updateGradInput_3", &cpu_SparseToDense_updateGradInput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SparseToDense_updateGradInput_4", &cpu_SparseToDense_updateGradInput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SparseToDense_updateGradInput_4", &cpu_SparseToDense_updateGradInput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SubmanifoldConvolution_updateOutput_1", &cpu_SubmanifoldConvolution_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SubmanifoldConvolution_updateOutput_1", &cpu_SubmanifoldConvolution_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SubmanifoldConvolution_updateOutput_2", &cpu_SubmanifoldConvolution_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SubmanifoldConvolution_updateOutput_2", &cpu_SubmanifoldConvolution_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SubmanifoldConvolution_updateOutput_3", &cpu_SubmanifoldConvolution_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SubmanifoldConvolution_updateOutput_3", &cpu_SubmanifoldConvolution_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SubmanifoldConvolution_updateOutput_4", &cpu_SubmanifoldConvolution_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SubmanifoldConvolution_updateOutput_4", &cpu_SubmanifoldConvolution_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SubmanifoldConvolution_backward_1", &cpu_SubmanifoldConvolution_backward<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SubmanifoldConvolution_backward_1", &cpu_SubmanifoldConvolution_backward<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SubmanifoldConvolution_backward_2", &cpu_SubmanifoldConvolution_backward<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SubmanifoldConvolution_backward_2", &cpu_SubmanifoldConvolution_backward<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SubmanifoldConvolution_backward_3", &cpu_SubmanifoldConvolution_backward<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SubmanifoldConvolution_backward_3", &cpu_SubmanifoldConvolution_backward<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_SubmanifoldConvolution_backward_4", &cpu_SubmanifoldConvolution_backward<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_SubmanifoldConvolution_backward_4", &cpu_SubmanifoldConvolution_backward<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_OutputStationarySubmanifoldConvolution_updateOutput_1", &cpu_OutputStationarySubmanifoldConvolution_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_OutputStationarySubmanifoldConvolution_updateOutput_1", &cpu_OutputStationarySubmanifoldConvolution_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_OutputStationarySubmanifoldConvolution_updateOutput_2", &cpu_OutputStationarySubmanifoldConvolution_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_OutputStationarySubmanifoldConvolution_updateOutput_2", &cpu_OutputStationarySubmanifoldConvolution_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_OutputStationarySubmanifoldConvolution_updateOutput_3", &cpu_OutputStationarySubmanifoldConvolution_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_OutputStationarySubmanifoldConvolution_updateOutput_3", &cpu_OutputStationarySubmanifoldConvolution_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_OutputStationarySubmanifoldConvolution_updateOutput_4", &cpu_OutputStationarySubmanifoldConvolution_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_OutputStationarySubmanifoldConvolution_updateOutput_4", &cpu_OutputStationarySubmanifoldConvolution_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_InputLayer_updateOutput_1", &cpu_InputLayer_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_InputLayer_updateOutput_1", &cpu_InputLayer_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_InputLayer_updateOutput_2", &cpu_InputLayer_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_InputLayer_updateOutput_2", &cpu_InputLayer_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_InputLayer_updateOutput_3", &cpu_InputLayer_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_InputLayer_updateOutput_3", &cpu_InputLayer_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_InputLayer_updateOutput_4", &cpu_InputLayer_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_InputLayer_updateOutput_4", &cpu_InputLayer_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_InputLayer_updateGradInput_1", &cpu_InputLayer_updateGradInput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_InputLayer_updateGradInput_1", &cpu_InputLayer_updateGradInput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_InputLayer_updateGradInput_2", &cpu_InputLayer_updateGradInput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_InputLayer_updateGradInput_2", &cpu_InputLayer_updateGradInput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_InputLayer_updateGradInput_3", &cpu_InputLayer_updateGradInput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_InputLayer_updateGradInput_3", &cpu_InputLayer_updateGradInput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_InputLayer_updateGradInput_4", &cpu_InputLayer_updateGradInput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_InputLayer_updateGradInput_4", &cpu_InputLayer_updateGradInput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_OutputLayer_updateOutput_1", &cpu_OutputLayer_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_OutputLayer_updateOutput_1", &cpu_OutputLayer_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_OutputLayer_updateOutput_2", &cpu_OutputLayer_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_OutputLayer_updateOutput_2", &cpu_OutputLayer_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_OutputLayer_updateOutput_3", &cpu_OutputLayer_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_OutputLayer_updateOutput_3", &cpu_OutputLayer_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_OutputLayer_updateOutput_4", &cpu_OutputLayer_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_OutputLayer_updateOutput_4", &cpu_OutputLayer_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_OutputLayer_updateGradInput_1", &cpu_OutputLayer_updateGradInput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_OutputLayer_updateGradInput_1", &cpu_OutputLayer_updateGradInput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_OutputLayer_updateGradInput_2", &cpu_OutputLayer_updateGradInput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_OutputLayer_updateGradInput_2", &cpu_OutputLayer_updateGradInput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_OutputLayer_updateGradInput_3", &cpu_OutputLayer_updateGradInput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_OutputLayer_updateGradInput_3", &cpu_OutputLayer_updateGradInput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_OutputLayer_updateGradInput_4", &cpu_OutputLayer_updateGradInput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_OutputLayer_updateGradInput_4", &cpu_OutputLayer_updateGradInput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLInputLayer_updateOutput_1", &cpu_BLInputLayer_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLInputLayer_updateOutput_1", &cpu_BLInputLayer_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLInputLayer_updateOutput_2", &cpu_BLInputLayer_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLInputLayer_updateOutput_2", &cpu_BLInputLayer_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLInputLayer_updateOutput_3", &cpu_BLInputLayer_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLInputLayer_updateOutput_3", &cpu_BLInputLayer_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLInputLayer_updateOutput_4", &cpu_BLInputLayer_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLInputLayer_updateOutput_4", &cpu_BLInputLayer_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLInputLayer_updateGradInput_1", &cpu_BLInputLayer_updateGradInput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLInputLayer_updateGradInput_1", &cpu_BLInputLayer_updateGradInput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLInputLayer_updateGradInput_2", &cpu_BLInputLayer_updateGradInput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLInputLayer_updateGradInput_2", &cpu_BLInputLayer_updateGradInput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLInputLayer_updateGradInput_3", &cpu_BLInputLayer_updateGradInput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLInputLayer_updateGradInput_3", &cpu_BLInputLayer_updateGradInput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLInputLayer_updateGradInput_4", &cpu_BLInputLayer_updateGradInput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLInputLayer_updateGradInput_4", &cpu_BLInputLayer_updateGradInput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLOutputLayer_updateOutput_1", &cpu_BLOutputLayer_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLOutputLayer_updateOutput_1", &cpu_BLOutputLayer_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLOutputLayer_updateOutput_2", &cpu_BLOutputLayer_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLOutputLayer_updateOutput_2", &cpu_BLOutputLayer_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLOutputLayer_updateOutput_3", &cpu_BLOutputLayer_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLOutputLayer_updateOutput_3", &cpu_BLOutputLayer_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLOutputLayer_updateOutput_4", &cpu_BLOutputLayer_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLOutputLayer_updateOutput_4", &cpu_BLOutputLayer_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLOutputLayer_updateGradInput_1", &cpu_BLOutputLayer_updateGradInput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLOutputLayer_updateGradInput_1", &cpu_BLOutputLayer_updateGradInput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLOutputLayer_updateGradInput_2", &cpu_BLOutputLayer_updateGradInput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLOutputLayer_updateGradInput_2", &cpu_BLOutputLayer_updateGradInput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLOutputLayer_updateGradInput_3", &cpu_BLOutputLayer_updateGradInput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLOutputLayer_updateGradInput_3", &cpu_BLOutputLayer_updateGradInput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_BLOutputLayer_updateGradInput_4", &cpu_BLOutputLayer_updateGradInput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_BLOutputLayer_updateGradInput_4", &cpu_BLOutputLayer_updateGradInput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_UnPooling_updateOutput_1", &cpu_UnPooling_updateOutput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_UnPooling_updateOutput_1", &cpu_UnPooling_updateOutput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_UnPooling_updateOutput_2", &cpu_UnPooling_updateOutput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_UnPooling_updateOutput_2", &cpu_UnPooling_updateOutput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_UnPooling_updateOutput_3", &cpu_UnPooling_updateOutput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_UnPooling_updateOutput_3", &cpu_UnPooling_updateOutput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_UnPooling_updateOutput_4", &cpu_UnPooling_updateOutput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_UnPooling_updateOutput_4", &cpu_UnPooling_updateOutput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_UnPooling_updateGradInput_1", &cpu_UnPooling_updateGradInput<float,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_UnPooling_updateGradInput_1", &cpu_UnPooling_updateGradInput<double,1>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_UnPooling_updateGradInput_2", &cpu_UnPooling_updateGradInput<float,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_UnPooling_updateGradInput_2", &cpu_UnPooling_updateGradInput<double,2>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_UnPooling_updateGradInput_3", &cpu_UnPooling_updateGradInput<float,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_UnPooling_updateGradInput_3", &cpu_UnPooling_updateGradInput<double,3>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_float_UnPooling_updateGradInput_4", &cpu_UnPooling_updateGradInput<float,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
+m.def("cpu_double_UnPooling_updateGradInput_4", &cpu_UnPooling_updateGradInput<double,4>, "", pybind11::call_guard<pybind11::gil_scoped_release>());
 
 m.def("n_rulebook_bits", []() {return 8*sizeof(Int);}, "");
+// Bytes allocated by rulebook copies and CPU convolution scratch space so far
+m.def("scratch_bytes", []() {return scratchBytes().load();}, "");
+// The size of the OpenMP teams that the CPU kernels of the calling thread use
+m.def("get_omp_threads", []() {
+#if defined(_OPENMP)
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}, "");
+m.def("set_omp_threads", [](int n) {
+#if defined(_OPENMP)
+  omp_set_num_threads(n);
+#endif
+}, "");
 }
@@ -19,7 +19,7 @@ from .identity import Identity
 from .inputBatch import InputBatch
 from .ioLayers import InputLayer, OutputLayer, BLInputLayer, BLOutputLayer, InputLayerInput
 from .maxPooling import MaxPooling
-from .metadata import Metadata
+from .metadata import Metadata, RuleBookLookahead, load_rulebooks, save_rulebooks
 from .networkArchitectures import *
 from .networkInNetwork import NetworkInNetwork
 from .randomizedStrideConvolution import RandomizedStrideConvolution
@@ -31,6 +31,7 @@ from .sparsify import Sparsify
 from .submanifoldConvolution import SubmanifoldConvolution, ValidConvolution
 from .tables import *
 from .unPooling import UnPooling
+from .utils import rulebook_plan
 
 
 def concatenate_feature_planes(input):
@@ -45,6 +45,11 @@ class AveragePooling(Module):
     def input_spatial_size(self, out_size):
         return (out_size - 1) * self.pool_stride + self.pool_size
 
+    def rulebook_requests(self, plan, spatial_size):
+        out_size = (spatial_size - self.pool_size) / self.pool_stride + 1
+        plan.append((CONVOLUTION_RULEBOOK, spatial_size, out_size, self.pool_size, self.pool_stride))
+        return out_size
+
     def __repr__(self):
         s = 'AveragePooling'
         if self.pool_size.max().item() == self.pool_size.min().item() and\
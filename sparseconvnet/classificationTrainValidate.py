@@ -62,6 +62,8 @@ def ClassificationTrainValidate(model, dataset, p):
         model.cuda()
     if 'test_reps' not in p:
         p['test_reps'] = 1
+    if 'rulebook_cache' not in p:
+        p['rulebook_cache'] = None
     optimizer = optim.SGD(model.parameters(),
                           lr=p['initial_lr'],
                           momentum=p['momentum'],
@@ -77,6 +79,10 @@ def ClassificationTrainValidate(model, dataset, p):
         p['epoch'] = 1
     print(p)
     print('#parameters', sum([x.nelement() for x in model.parameters()]))
+    # For test_reps > 1: a directory to keep the rulebooks of the validation
+    # batches in, if they are the same each rep and each epoch
+    rulebook_cache = p['rulebook_cache']
+    first_epoch = p['epoch']
     for epoch in range(p['epoch'], p['n_epochs'] + 1):
         model.train()
         stats = {}
@@ -146,13 +152,29 @@ def ClassificationTrainValidate(model, dataset, p):
                 pr = []
                 ta = []
                 idxs = []
-                for batch in dataset['val']():
+                for i, batch in enumerate(dataset['val']()):
                     if p['use_cuda']:
                         batch['input'] = batch['input'].cuda()
                         batch['target'] = batch['target'].cuda()
                         batch['idx'] = batch['idx'].cuda()
                     batch['input'].to_variable()
+                    # One file per batch, so the cache stays the size of the
+                    # validation set
+                    name = 'val%d' % i
+                    cached = rulebook_cache and s.load_rulebooks(
+                        batch['input'].metadata, rulebook_cache, name)
                     output = model(batch['input'])
+                    if rulebook_cache and not cached:
+                        if rep > 1 or epoch > first_epoch:
+                            # The batches change from one pass to the next
+                            # (e.g. with augmentation): nothing would be
+                            # reused
+                            print('rulebook_cache: the validation batches '
+                                  'are not the same each rep; not caching')
+                            rulebook_cache = None
+                        else:
+                            s.save_rulebooks(batch['input'].metadata,
+                                             rulebook_cache, name)
                     pr.append(output.detach())
                     ta.append(batch['target'])
                     idxs.append(batch['idx'])
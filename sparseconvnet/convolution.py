@@ -66,6 +66,11 @@ class Convolution(Module):
     def input_spatial_size(self, out_size):
         return (out_size - 1) * self.filter_stride + self.filter_size
 
+    def rulebook_requests(self, plan, spatial_size):
+        out_size = (spatial_size - self.filter_size) / self.filter_stride + 1
+        plan.append((CONVOLUTION_RULEBOOK, spatial_size, out_size, self.filter_size, self.filter_stride))
+        return out_size
+
 class ConvolutionFunction(Function):
     @staticmethod
     def forward(
@@ -67,6 +67,12 @@ class Deconvolution(Module):
                 self.filter_size == out_size).all()
         return in_size
 
+    def rulebook_requests(self, plan, spatial_size):
+        out_size = (spatial_size - 1) * self.filter_stride + self.filter_size
+        plan.append((CONVOLUTION_RULEBOOK, out_size, spatial_size,
+                     self.filter_size, self.filter_stride))
+        return out_size
+
 class DeconvolutionFunction(Function):
     @staticmethod
     def forward(
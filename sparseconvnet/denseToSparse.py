@@ -39,6 +39,9 @@ class DenseToSparse(Module):
     def input_spatial_size(self, out_size):
         return out_size
 
+    def rulebook_requests(self, plan, spatial_size):
+        return None
+
 class DenseToSparseFunction(Function):
     @staticmethod
     def forward(
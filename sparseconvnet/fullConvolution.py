@@ -66,6 +66,10 @@ class FullConvolution(Module):
     def input_spatial_size(self, out_size):
         return (out_size - 1) * self.filter_stride + self.filter_size
 
+    def rulebook_requests(self, plan, spatial_size):
+        # The output has Metadata of its own
+        return None
+
 class FullConvolutionFunction(Function):
     @staticmethod
     def forward(
@@ -73,12 +73,56 @@ class InputBatch(SparseConvNetTensor):
         Allows precomputation of 'rulebooks' in data loading threads.
         Use size == 2 if downsizing with size-2 stride-2 operations
         Use size == 3 if downsizing with size-3 stride-2 operations
+        Otherwise pass size == sparseconvnet.rulebook_plan(network,
+        spatial_size) to build exactly the rulebooks that network uses,
+        with independent ones built in parallel.
         """
-        if size == 2:
+        if isinstance(size, list):
+            if size:
+                self.metadata.precomputeRuleBooks(torch.LongTensor(
+                    [[kind] + i.tolist() + o.tolist() + f.tolist() + s.tolist()
+                     for kind, i, o, f, s in size]))
+        elif size == 2:
             self.metadata.generateRuleBooks2s2(self.metadata)
-        if size == 3 :
+        elif size == 3:
             self.metadata.generateRuleBooks3s2(self.metadata)
 
+    def morton_order(self):
+        """
+        Optional.
+        Renumber the active sites in Morton order, so that sites that are
+        close in space occupy nearby rows of the feature matrices; this
+        improves the cache behaviour of the convolutions.
+        Call after all the locations have been set, and before
+        precompute_metadata. The rows of self.features are permuted; use
+        self.get_spatial_locations() to find the new order. They must still
+        be the CPU float features built by set_location(s); convert them
+        afterwards.
+        """
+        t = self.features.type()
+        if self.features.numel() and t != 'torch.FloatTensor':
+            raise TypeError('morton_order needs torch.FloatTensor features, '
+                            'not ' + t)
+        self.metadata.mortonOrderInput(self.features)
+
+    def __getstate__(self):
+        """
+        Pickling support, so that InputBatches can be built, and their
+        metadata precomputed, in DataLoader worker processes. The metadata
+        travels as a ByteTensor, which torch.multiprocessing passes on
+        through shared memory.
+        """
+        state = self.__dict__.copy()
+        state['metadata'] = torch.ByteTensor()
+        self.metadata.serializeRuleBooks(state['metadata'])
+        return state
+
+    def __setstate__(self, state):
+        self.__dict__.update(state)
+        self.metadata = Metadata(self.dimension)
+        if not self.metadata.deserializeRuleBooks(state['metadata']):
+            raise RuntimeError('bad metadata segment')
+
     "Deprecated method names."
     def addSample(self):
         self.metadata.batchAddSample()
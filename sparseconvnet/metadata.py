@@ -9,9 +9,83 @@ Store Metadata relating to which spatial locations are active at each scale.
 Convolutions, submanifold convolutions and 'convolution reversing' deconvolutions
 all coexist within the same MetaData object as long as each spatial size
 only occurs once.
+
+m.setSortedRuleBooks(True) makes m build its submanifold and strided
+convolution rulebooks by sorting the active sites and merging them, rather
+than by hash table lookups.
+
+save_rulebooks/load_rulebooks keep the grids and rulebooks built for a batch
+in a directory, in files named after a hash of the input locations or after
+the batch, so that later passes over the same batch (e.g. repeated test
+passes) can skip building them. They apply to metadata whose input locations
+are set before the forward pass, as with InputBatch.
+
+RuleBookLookahead builds the rulebooks for each batch on a background thread,
+while the layers that do not need them yet run.
+
+The layers may run in several threads at once on the same metadata, e.g. for
+independent branches of a network: each rulebook is then built by one thread,
+while the others wait for it.
 """
 
+import os
+import torch
 from .utils import dim_fn
 
 def Metadata(dim):
     return dim_fn(dim,'Metadata')()
+
+def _rulebook_file(metadata, directory, name=None):
+    if name is not None:
+        return os.path.join(directory, name + '.scnrules')
+    key = metadata.inputKey()
+    return os.path.join(directory, key + '.scnrules') if key else None
+
+def load_rulebooks(metadata, directory, name=None):
+    """
+    Load the rulebooks saved for the input locations of metadata, if there
+    are any; returns True if they were loaded. By default the files are named
+    after a hash of the input locations; pass name to use one file per batch
+    slot instead, which is only loaded if it holds the same input locations.
+    """
+    f = _rulebook_file(metadata, directory, name)
+    return f is not None and os.path.isfile(f) and metadata.loadRuleBooks(f)
+
+def save_rulebooks(metadata, directory, name=None):
+    "Save the rulebooks of metadata, after the forward pass"
+    f = _rulebook_file(metadata, directory, name)
+    if f is None:
+        return
+    if not os.path.isdir(directory):
+        os.makedirs(directory)
+    tmp = f + '.' + str(os.getpid())
+    if metadata.saveRuleBooks(tmp):
+        os.rename(tmp, f)
+    elif os.path.isfile(tmp):
+        os.remove(tmp)
+
+class RuleBookLookahead(object):
+    """
+    Build the rulebooks of each batch on a background thread, following the
+    requests the network made on the previous batch; the layers only wait for
+    rulebooks that are not ready yet. For a network whose sequence of layers
+    does not change:
+
+        lookahead = scn.RuleBookLookahead()
+        for batch in batches:
+            lookahead.start(batch['input'].metadata)
+            output = model(batch['input'])
+    """
+    def __init__(self):
+        self.metadata = None
+        self.plan = torch.LongTensor()
+
+    def start(self, metadata):
+        "Call once the input locations of metadata are set"
+        if self.metadata is not None:
+            self.metadata.getRecordedPlan(self.plan)
+            self.metadata.recordRuleBooks(False)
+        metadata.recordRuleBooks(True)
+        if self.plan.numel():
+            metadata.startLookahead(self.plan)
+        self.metadata = metadata
@@ -79,6 +79,13 @@ class RandomizedStrideConvolution(Module):
     def input_spatial_size(self, out_size):
         return (out_size - 1) * self.filter_stride + self.filter_size
 
+    def rulebook_requests(self, plan, spatial_size):
+        out_size = (spatial_size - self.filter_size) / self.filter_stride + 1
+        kind = RANDOMIZED_STRIDE_RULEBOOK if self.training \
+            else CONVOLUTION_RULEBOOK
+        plan.append((kind, spatial_size, out_size, self.filter_size, self.filter_stride))
+        return out_size
+
 class RandomizedStrideConvolutionFunction(Function):
     @staticmethod
     def forward(
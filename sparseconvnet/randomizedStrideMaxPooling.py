@@ -97,6 +97,13 @@ class RandomizedStrideMaxPooling(Module):
     def input_spatial_size(self, out_size):
         return (out_size - 1) * self.pool_stride + self.pool_size
 
+    def rulebook_requests(self, plan, spatial_size):
+        out_size = (spatial_size - self.pool_size) / self.pool_stride + 1
+        kind = RANDOMIZED_STRIDE_RULEBOOK if self.training \
+            else CONVOLUTION_RULEBOOK
+        plan.append((kind, spatial_size, out_size, self.pool_size, self.pool_stride))
+        return out_size
+
     def __repr__(self):
         s = 'RandomizedStrideMaxPooling'
         if self.pool_size.max().item() == self.pool_size.min().item() and\
@@ -5,6 +5,7 @@
 # LICENSE file in the root directory of this source tree.
 
 from torch.nn import Sequential as S
+from .utils import rulebook_requests
 
 class Sequential(S):
     def input_spatial_size(self, out_size):
@@ -12,6 +13,13 @@ class Sequential(S):
             out_size = self._modules[m].input_spatial_size(out_size)
         return out_size
 
+    def rulebook_requests(self, plan, spatial_size):
+        for m in self._modules.values():
+            if spatial_size is None:
+                break
+            spatial_size = rulebook_requests(m, plan, spatial_size)
+        return spatial_size
+
     def add(self, module):
         self._modules[str(len(self._modules))] = module
         return self
@@ -78,6 +78,11 @@ class SparseToDense(Module):
     def input_spatial_size(self, out_size):
         return out_size
 
+    def rulebook_requests(self, plan, spatial_size):
+        plan.append((SPARSE_TO_DENSE_RULEBOOK, spatial_size, spatial_size,
+                     spatial_size, spatial_size))
+        return None
+
     def __repr__(self):
         return 'SparseToDense(' + str(self.dimension) + \
             ',' + str(self.nPlanes) + ')'
@@ -34,3 +34,7 @@ class Sparsify(Module):
             active.byte(),
             active.cumsum(0))
         return output
+
+    def rulebook_requests(self, plan, spatial_size):
+        # The output has Metadata of its own
+        return None
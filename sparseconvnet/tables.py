@@ -4,10 +4,15 @@
 # This source code is licensed under the license found in the
 # LICENSE file in the root directory of this source tree.
 
+import threading as _threading
 from torch.autograd import Function
 from torch.nn import Module
 from .utils import *
 from .sparseConvNetTensor import SparseConvNetTensor
+try:
+    import queue as _queue
+except BaseException:
+    import Queue as _queue
 
 
 class JoinTable(Module):
@@ -21,6 +26,9 @@ class JoinTable(Module):
     def input_spatial_size(self, out_size):
         return out_size
 
+    def rulebook_requests(self, plan, spatial_size):
+        return spatial_size[0]
+
 
 class AddTable(Module):
     def forward(self, input):
@@ -33,10 +41,31 @@ class AddTable(Module):
     def input_spatial_size(self, out_size):
         return out_size
 
+    def rulebook_requests(self, plan, spatial_size):
+        return spatial_size[0]
+
 
 class ConcatTable(Module):
+    """
+    With parallel=True, the branches run at the same time on CPU, on a pool of
+    threads shared by all the ConcatTables: the CPU kernels release the GIL,
+    and the branches can share the input's Metadata. The OpenMP threads that
+    one branch would use are shared out between the branches, so they run
+    serially if there is only one. The backward pass still runs the branches
+    one after another.
+    """
+    def __init__(self, parallel=False):
+        Module.__init__(self)
+        self.parallel = parallel
+
     def forward(self, input):
-        return [module(input) for module in self._modules.values()]
+        modules = list(self._modules.values())
+        if getattr(self, 'parallel', False) and len(modules) > 1 and \
+                not input.features.is_cuda and \
+                not getattr(_branch_pool_thread, 'active', False) and \
+                scn.get_omp_threads() > 1:
+            return _run_branches(modules, input)
+        return [module(input) for module in modules]
 
     def add(self, module):
         self._modules[str(len(self._modules))] = module
@@ -44,3 +73,83 @@ class ConcatTable(Module):
 
     def input_spatial_size(self, out_size):
         return self._modules['0'].input_spatial_size(out_size)
+
+    def rulebook_requests(self, plan, spatial_size):
+        return [rulebook_requests(module, plan, spatial_size)
+                for module in self._modules.values()]
+
+
+def set_parallel_branches(network, parallel=True):
+    "Set whether the ConcatTables in network run their branches in parallel"
+    for m in network.modules():
+        if isinstance(m, ConcatTable):
+            m.parallel = parallel
+
+
+class _Branch(object):
+    "Some of the branches of a ConcatTable, to run one after another"
+    def __init__(self, modules, input, omp_threads):
+        self.modules = modules
+        self.input = input
+        self.omp_threads = omp_threads
+        self.grad_enabled = torch.is_grad_enabled()
+        self.output = None
+        self.error = None
+        self.done = _threading.Event()
+
+    def run(self):
+        # Grad mode and the OpenMP team size are per thread
+        omp_threads = scn.get_omp_threads()
+        scn.set_omp_threads(self.omp_threads)
+        try:
+            with torch.set_grad_enabled(self.grad_enabled):
+                self.output = [module(self.input) for module in self.modules]
+        except BaseException as e:
+            self.error = e
+        finally:
+            scn.set_omp_threads(omp_threads)
+        self.done.set()
+
+    def result(self):
+        self.done.wait()
+        if self.error is not None:
+            raise self.error
+        return self.output
+
+
+_branch_pool_size = 4
+_branch_pool = None
+_branch_pool_lock = _threading.Lock()
+_branch_pool_thread = _threading.local()
+
+
+def _branch_pool_worker(branches):
+    # ConcatTables inside a branch run serially, so that the threads of the
+    # pool never wait for each other
+    _branch_pool_thread.active = True
+    while True:
+        branches.get().run()
+
+
+def _run_branches(modules, input):
+    global _branch_pool
+    with _branch_pool_lock:
+        if _branch_pool is None:
+            _branch_pool = _queue.Queue()
+            for i in range(_branch_pool_size):
+                t = _threading.Thread(target=_branch_pool_worker,
+                                     args=(_branch_pool,))
+                t.daemon = True
+                t.start()
+    # Split the modules into at most one group per OpenMP thread, each with an
+    # equal share of them, so the cores are not oversubscribed
+    omp_threads = scn.get_omp_threads()
+    n = min(len(modules), omp_threads, _branch_pool_size + 1)
+    branches = [_Branch(modules[i::n], input, omp_threads // n)
+                for i in range(n)]
+    for b in branches[1:]:
+        _branch_pool.put(b)
+    # The first group runs in this thread
+    branches[0].run()
+    outputs = [b.result() for b in branches]
+    return [outputs[i % n][i // n] for i in range(len(modules))]
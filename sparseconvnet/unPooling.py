@@ -77,6 +77,11 @@ class UnPooling(Module):
         return output
     def input_spatial_size(self, out_size):
         return (out_size - 1) * self.pool_stride + self.pool_size
+    def rulebook_requests(self, plan, spatial_size):
+        out_size = (spatial_size - 1) * self.pool_stride + self.pool_size
+        plan.append((CONVOLUTION_RULEBOOK, out_size, spatial_size,
+                     self.pool_size, self.pool_stride))
+        return out_size
     def __repr__(self):
         s = 'UnPooling'
         if self.pool_size.max() == self.pool_size.min() and\
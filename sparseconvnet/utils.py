@@ -38,6 +38,44 @@ def dim_typed_fn(dimension, t, name):
     return f
 
 
+# Kinds of rulebook, numbered as by RuleBookKind in SCN/Metadata/Metadata.h
+SUBMANIFOLD_RULEBOOK = 0
+NEIGHBOUR_TABLE = 1
+CONVOLUTION_RULEBOOK = 2
+RANDOMIZED_STRIDE_RULEBOOK = 3
+SPARSE_TO_DENSE_RULEBOOK = 4
+
+
+def rulebook_requests(module, plan, spatial_size):
+    """
+    Add the rulebooks that module uses, on an input of size spatial_size, to
+    plan; returns the spatial size of the output, or None if the layers after
+    module do not share its input's Metadata. Modules that build rulebooks, or
+    contain other modules, define rulebook_requests(plan, spatial_size); the
+    others leave the spatial size unchanged.
+    """
+    if hasattr(module, 'rulebook_requests'):
+        return module.rulebook_requests(plan, spatial_size)
+    return spatial_size
+
+
+def rulebook_plan(module, spatial_size):
+    """
+    The rulebooks that module (e.g. a sparseconvnet.Sequential) uses on an
+    input of size spatial_size, as a list of
+      (kind, input size, output size, filter size, stride)
+    tuples, for InputBatch.precompute_metadata. The plan stops at layers that
+    give their output Metadata of its own (FullConvolution, Sparsify, ...).
+    It depends on the mode: in training mode the randomized stride layers
+    use randomized rulebooks.
+    """
+    plan = []
+    if isinstance(spatial_size, (list, tuple)):
+        spatial_size = torch.LongTensor(spatial_size)
+    rulebook_requests(module, plan, spatial_size)
+    return plan
+
+
 def optionalTensor(a, b):
     return getattr(a, b) if hasattr(a, b) else torch.Tensor()
 def optionalTensorReturn(a):